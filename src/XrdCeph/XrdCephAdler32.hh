@@ -0,0 +1,149 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// This file is part of the XRootD software suite.
+//
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//
+// In applying this licence, CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//------------------------------------------------------------------------------
+
+#ifndef __XRD_CEPH_ADLER32_HH__
+#define __XRD_CEPH_ADLER32_HH__
+
+#include <stdint.h>
+#include <stddef.h>
+#if defined(__x86_64__)
+#include <tmmintrin.h>
+#endif
+
+//------------------------------------------------------------------------------
+//! Adler32 computation for the checksums streamed while files are written.
+//!
+//! Uses an SSSE3 kernel processing 32 bytes per iteration when the CPU has
+//! it, detected at run time, and a plain implementation otherwise. Values
+//! are the standard (zlib) adler32, starting from 1, and can be chained by
+//! passing the result of the previous part as prev. Checksums of separate
+//! parts can be combined, knowing the length of the second one.
+//------------------------------------------------------------------------------
+
+class XrdCephAdler32 {
+
+public:
+
+  /// adler32 of the given data, continuing from prev
+  static uint32_t calc(const void *data, size_t len, uint32_t prev = 1) {
+#if defined(__x86_64__)
+    if (simdAvailable()) return calcSimd(data, len, prev);
+#endif
+    return calcSw(data, len, prev);
+  }
+
+  /// plain implementation, also used as reference
+  static uint32_t calcSw(const void *data, size_t len, uint32_t prev = 1) {
+    const unsigned char *p = (const unsigned char*)data;
+    uint32_t s1 = prev & 0xffff;
+    uint32_t s2 = prev >> 16;
+    while (len > 0) {
+      // NMAX bytes can be summed before the sums may overflow
+      size_t n = len < NMAX ? len : NMAX;
+      len -= n;
+      while (n--) {
+        s1 += *p++;
+        s2 += s1;
+      }
+      s1 %= Base;
+      s2 %= Base;
+    }
+    return s1 | (s2 << 16);
+  }
+
+#if defined(__x86_64__)
+  static bool simdAvailable() {
+    static const bool simd = (__builtin_cpu_init(), __builtin_cpu_supports("ssse3"));
+    return simd;
+  }
+
+  /// SSSE3 kernel : per block of 32 bytes, s1 gets the plain sum of the
+  /// bytes and s2 their sum weighted by 32..1, plus 32 times the previous s1
+  __attribute__((target("ssse3")))
+  static uint32_t calcSimd(const void *data, size_t len, uint32_t prev = 1) {
+    const unsigned char *p = (const unsigned char*)data;
+    uint32_t s1 = prev & 0xffff;
+    uint32_t s2 = prev >> 16;
+    size_t blocks = len / 32;
+    len -= blocks * 32;
+    const __m128i tap1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                       24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i tap2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9,
+                                       8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    while (blocks) {
+      size_t n = blocks < NMAX / 32 ? blocks : NMAX / 32;
+      blocks -= n;
+      // sum of the s1 values at the start of each block
+      __m128i vps = _mm_set_epi32(0, 0, 0, s1 * n);
+      __m128i vs1 = _mm_setzero_si128();
+      __m128i vs2 = _mm_set_epi32(0, 0, 0, s2);
+      do {
+        const __m128i b1 = _mm_loadu_si128((const __m128i*)p);
+        const __m128i b2 = _mm_loadu_si128((const __m128i*)(p + 16));
+        vps = _mm_add_epi32(vps, vs1);
+        vs1 = _mm_add_epi32(vs1, _mm_sad_epu8(b1, zero));
+        vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_maddubs_epi16(b1, tap1), ones));
+        vs1 = _mm_add_epi32(vs1, _mm_sad_epu8(b2, zero));
+        vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_maddubs_epi16(b2, tap2), ones));
+        p += 32;
+      } while (--n);
+      vs2 = _mm_add_epi32(vs2, _mm_slli_epi32(vps, 5));
+      // horizontal sums
+      vs1 = _mm_add_epi32(vs1, _mm_shuffle_epi32(vs1, _MM_SHUFFLE(2, 3, 0, 1)));
+      vs1 = _mm_add_epi32(vs1, _mm_shuffle_epi32(vs1, _MM_SHUFFLE(1, 0, 3, 2)));
+      s1 += _mm_cvtsi128_si32(vs1);
+      vs2 = _mm_add_epi32(vs2, _mm_shuffle_epi32(vs2, _MM_SHUFFLE(2, 3, 0, 1)));
+      vs2 = _mm_add_epi32(vs2, _mm_shuffle_epi32(vs2, _MM_SHUFFLE(1, 0, 3, 2)));
+      s2 = _mm_cvtsi128_si32(vs2);
+      s1 %= Base;
+      s2 %= Base;
+    }
+    return calcSw(p, len, s1 | (s2 << 16));
+  }
+#endif
+
+  /// adler32 of the concatenation of two parts, the second one being len2 long
+  static uint32_t combine(uint32_t adler1, uint32_t adler2, uint64_t len2) {
+    uint32_t rem = (uint32_t)(len2 % Base);
+    uint32_t sum1 = adler1 & 0xffff;
+    uint32_t sum2 = (uint32_t)(((uint64_t)rem * sum1) % Base);
+    sum1 += (adler2 & 0xffff) + Base - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + Base - rem;
+    if (sum1 >= Base) sum1 -= Base;
+    if (sum1 >= Base) sum1 -= Base;
+    if (sum2 >= 2 * Base) sum2 -= 2 * Base;
+    if (sum2 >= Base) sum2 -= Base;
+    return sum1 | (sum2 << 16);
+  }
+
+private:
+
+  static const uint32_t Base = 65521;
+  /// largest n such that 255n(n+1)/2 + (n+1)(Base-1) fits in 32 bits
+  static const size_t NMAX = 5552;
+
+};
+
+#endif /* __XRD_CEPH_ADLER32_HH__ */
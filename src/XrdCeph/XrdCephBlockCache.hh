@@ -0,0 +1,227 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// This file is part of the XRootD software suite.
+//
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//
+// In applying this licence, CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//------------------------------------------------------------------------------
+
+#ifndef __XRD_CEPH_BLOCK_CACHE_HH__
+#define __XRD_CEPH_BLOCK_CACHE_HH__
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
+#include "XrdSys/XrdSysPthread.hh"
+
+//------------------------------------------------------------------------------
+//! Key of a block of the XrdCephBlockCache : one RADOS object of a file.
+//! The generation changes whenever the file may have changed, so that
+//! stale blocks are never found again and simply age out of the cache.
+//------------------------------------------------------------------------------
+
+struct XrdCephBlockKey {
+  std::string pool;
+  std::string name;
+  uint64_t objectNo;
+  uint64_t generation;
+  bool operator==(const XrdCephBlockKey &o) const {
+    return objectNo == o.objectNo && generation == o.generation &&
+      name == o.name && pool == o.pool;
+  }
+};
+
+struct XrdCephBlockKeyHash {
+  size_t operator()(const XrdCephBlockKey &k) const {
+    std::hash<std::string> h;
+    return h(k.name) ^ (h(k.pool) << 1) ^ (k.objectNo * 0x9e3779b97f4a7c15ull) ^ (k.generation << 7);
+  }
+};
+
+//------------------------------------------------------------------------------
+//! Process wide, memory bounded cache of file blocks, with 2Q eviction.
+//!
+//! New blocks enter a FIFO (A1in) limited to a quarter of the capacity.
+//! Blocks evicted from there leave their key in a ghost FIFO (A1out), and
+//! only blocks missed again while still remembered there enter the main
+//! LRU (Am). A large sequential scan hence only flushes A1in and leaves the
+//! frequently used blocks in Am untouched.
+//!
+//! Blocks are handed out as shared pointers, so that they can be used
+//! without holding the cache lock and survive their eviction.
+//! All operations take a single mutex, the copy of the data being done by
+//! the callers outside of it.
+//------------------------------------------------------------------------------
+
+template <typename V>
+class XrdCephBlockCache {
+
+public:
+
+  /// number of files whose generation is remembered, beyond which all files
+  /// move to a new epoch
+  static const size_t MaxGenerations = 100000;
+
+  XrdCephBlockCache() : m_capacity(0), m_inBytes(0), m_mainBytes(0), m_epoch(0), m_lastGeneration(0),
+                        m_hits(0), m_misses(0), m_evictions(0), m_invalidations(0) {}
+
+  /// sets the capacity in bytes, 0 disabling the cache. Not thread safe,
+  /// to be called at configuration time
+  void setCapacity(unsigned long long capacity) { m_capacity = capacity; }
+
+  bool enabled() const { return m_capacity > 0; }
+
+  /// current generation of a file, to be used in the keys of its blocks
+  uint64_t generation(const std::string &fileId) {
+    XrdSysMutexHelper lock(m_mutex);
+    auto it = m_generations.find(fileId);
+    return it == m_generations.end() ? m_epoch : it->second;
+  }
+
+  /// makes all currently cached blocks of a file unreachable
+  void invalidate(const std::string &fileId) {
+    XrdSysMutexHelper lock(m_mutex);
+    m_invalidations++;
+    // the map of generations is bounded by moving all files to a new epoch
+    // when too big. Generations only grow, so that blocks still being read
+    // under an old one can never be found again
+    if (m_generations.size() >= MaxGenerations) {
+      m_generations.clear();
+      m_epoch = ++m_lastGeneration;
+    }
+    m_generations[fileId] = ++m_lastGeneration;
+  }
+
+  /// looks up a block, returning a null pointer if not cached
+  std::shared_ptr<const V> get(const XrdCephBlockKey &key) {
+    XrdSysMutexHelper lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end() || it->second.queue == Ghost) {
+      m_misses++;
+      return std::shared_ptr<const V>();
+    }
+    m_hits++;
+    Entry &e = it->second;
+    if (e.queue == Main) {
+      m_main.splice(m_main.begin(), m_main, e.pos);
+    }
+    return e.value;
+  }
+
+  /// inserts a block of the given size in bytes
+  void put(const XrdCephBlockKey &key, std::shared_ptr<const V> value, size_t bytes) {
+    if (bytes > m_capacity) return;
+    XrdSysMutexHelper lock(m_mutex);
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+      if (it->second.queue != Ghost) return;
+      // seen recently, goes to the main queue
+      m_ghost.erase(it->second.pos);
+      m_main.push_front(key);
+      it->second.queue = Main;
+      it->second.pos = m_main.begin();
+      it->second.value = value;
+      it->second.bytes = bytes;
+      m_mainBytes += bytes;
+    } else {
+      m_in.push_front(key);
+      Entry &e = m_entries[key];
+      e.queue = In;
+      e.pos = m_in.begin();
+      e.value = value;
+      e.bytes = bytes;
+      m_inBytes += bytes;
+    }
+    evict();
+  }
+
+  unsigned long long hits() const { return m_hits; }
+  unsigned long long misses() const { return m_misses; }
+  unsigned long long evictions() const { return m_evictions; }
+  unsigned long long invalidations() const { return m_invalidations; }
+  unsigned long long usedBytes() {
+    XrdSysMutexHelper lock(m_mutex);
+    return m_inBytes + m_mainBytes;
+  }
+
+private:
+
+  enum Queue { In, Ghost, Main };
+
+  struct Entry {
+    Queue queue;
+    typename std::list<XrdCephBlockKey>::iterator pos;
+    std::shared_ptr<const V> value;
+    size_t bytes;
+  };
+
+  static const size_t MinGhosts = 1024;
+
+  /// evicts blocks until the cache fits its capacity. Called with the mutex
+  void evict() {
+    while (m_inBytes + m_mainBytes > m_capacity) {
+      if (!m_in.empty() && (m_inBytes > m_capacity / 4 || m_main.empty())) {
+        // oldest block of A1in, its key goes to the ghost queue
+        auto it = m_entries.find(m_in.back());
+        m_in.pop_back();
+        m_inBytes -= it->second.bytes;
+        it->second.value.reset();
+        it->second.bytes = 0;
+        it->second.queue = Ghost;
+        m_ghost.push_front(it->first);
+        it->second.pos = m_ghost.begin();
+        // the ghost queue remembers as many keys as A1in could hold blocks
+        size_t maxGhosts = m_in.size() > MinGhosts ? m_in.size() : MinGhosts;
+        while (m_ghost.size() > maxGhosts) {
+          m_entries.erase(m_ghost.back());
+          m_ghost.pop_back();
+        }
+      } else {
+        // least recently used block of Am
+        auto it = m_entries.find(m_main.back());
+        m_main.pop_back();
+        m_mainBytes -= it->second.bytes;
+        m_entries.erase(it);
+      }
+      m_evictions++;
+    }
+  }
+
+  XrdSysMutex m_mutex;
+  unsigned long long m_capacity;
+  std::unordered_map<XrdCephBlockKey, Entry, XrdCephBlockKeyHash> m_entries;
+  std::list<XrdCephBlockKey> m_in;
+  std::list<XrdCephBlockKey> m_ghost;
+  std::list<XrdCephBlockKey> m_main;
+  unsigned long long m_inBytes;
+  unsigned long long m_mainBytes;
+  std::unordered_map<std::string, uint64_t> m_generations;
+  // generation of the files not in m_generations
+  uint64_t m_epoch;
+  uint64_t m_lastGeneration;
+  std::atomic<unsigned long long> m_hits;
+  std::atomic<unsigned long long> m_misses;
+  std::atomic<unsigned long long> m_evictions;
+  std::atomic<unsigned long long> m_invalidations;
+
+};
+
+#endif /* __XRD_CEPH_BLOCK_CACHE_HH__ */
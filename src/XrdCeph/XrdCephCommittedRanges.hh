@@ -0,0 +1,108 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// This file is part of the XRootD software suite.
+//
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//
+// In applying this licence, CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//------------------------------------------------------------------------------
+
+#ifndef __XRD_CEPH_COMMITTED_RANGES_HH__
+#define __XRD_CEPH_COMMITTED_RANGES_HH__
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <map>
+#include <stdint.h>
+#include "XrdSys/XrdSysPthread.hh"
+
+//------------------------------------------------------------------------------
+//! Ranges of a file whose writes completed successfully.
+//!
+//! Writes may complete in any order. The contiguous committed prefix of the
+//! file only grows once all writes before it are in, and is kept apart so
+//! that it can be read without locking. Committed ranges beyond it are kept
+//! merged, they never overlap nor touch each other or the prefix.
+//------------------------------------------------------------------------------
+
+class XrdCephCommittedRanges {
+
+public:
+
+  XrdCephCommittedRanges() : m_prefix(0) {}
+
+  /// records that the write of [offset, offset+len[ completed successfully
+  void commit(uint64_t offset, uint64_t len) {
+    if (0 == len) return;
+    uint64_t start = offset;
+    uint64_t end = offset + len;
+    XrdSysMutexHelper lock(m_mutex);
+    uint64_t prefix = m_prefix.load(std::memory_order_relaxed);
+    if (end <= prefix) return;
+    // merge with the ranges overlapping or touching this one
+    auto it = m_ranges.upper_bound(start);
+    if (it != m_ranges.begin()) {
+      auto prev = std::prev(it);
+      if (prev->second >= start) {
+        start = prev->first;
+        end = std::max(end, prev->second);
+        m_ranges.erase(prev);
+      }
+    }
+    while (it != m_ranges.end() && it->first <= end) {
+      end = std::max(end, it->second);
+      it = m_ranges.erase(it);
+    }
+    if (start <= prefix) {
+      m_prefix.store(end, std::memory_order_release);
+    } else {
+      m_ranges[start] = end;
+    }
+  }
+
+  /// forgets what was committed beyond a new, smaller, size of the file
+  void truncate(uint64_t size) {
+    XrdSysMutexHelper lock(m_mutex);
+    if (m_prefix.load(std::memory_order_relaxed) > size) {
+      m_prefix.store(size, std::memory_order_release);
+    }
+    m_ranges.erase(m_ranges.lower_bound(size), m_ranges.end());
+    if (!m_ranges.empty()) {
+      auto last = std::prev(m_ranges.end());
+      last->second = std::min(last->second, size);
+    }
+  }
+
+  /// size of the beginning of the file whose writes all completed
+  uint64_t prefix() const { return m_prefix.load(std::memory_order_acquire); }
+
+  /// number of committed ranges beyond the prefix
+  size_t nbRanges() const {
+    XrdSysMutexHelper lock(m_mutex);
+    return m_ranges.size();
+  }
+
+private:
+
+  mutable XrdSysMutex m_mutex;
+  std::atomic<uint64_t> m_prefix;
+  // end of the committed ranges beyond the prefix, by start offset
+  std::map<uint64_t, uint64_t> m_ranges;
+};
+
+#endif /* __XRD_CEPH_COMMITTED_RANGES_HH__ */
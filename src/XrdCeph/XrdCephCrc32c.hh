@@ -0,0 +1,148 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// This file is part of the XRootD software suite.
+//
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//
+// In applying this licence, CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//------------------------------------------------------------------------------
+
+#ifndef __XRD_CEPH_CRC32C_HH__
+#define __XRD_CEPH_CRC32C_HH__
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/types.h>
+#include "XrdOuc/XrdOucCRC.hh"
+#include "XrdOuc/XrdOucPgrwUtils.hh"
+
+//------------------------------------------------------------------------------
+//! CRC32C (Castagnoli) helpers complementing XrdOucCRC and XrdOucPgrwUtils,
+//! which do the actual checksumming.
+//!
+//! combine gives the crc of the concatenation of two parts from their crcs,
+//! as needed when parts of a file are checksummed out of order.
+//------------------------------------------------------------------------------
+
+class XrdCephCrc32c {
+
+public:
+
+  /// crc of the concatenation of two parts, the second one being len2 long.
+  /// The first crc is shifted by len2 zero bytes, using the precomputed
+  /// powers x^(2^k) of the polynomial
+  static uint32_t combine(uint32_t crc1, uint32_t crc2, uint64_t len2) {
+    const uint32_t *x2n = powers().x2n;
+    // x^(8*len2) modulo the polynomial
+    uint32_t op = 1u << 31;
+    for (unsigned int k = 3; len2; len2 >>= 1, k++) {
+      if (len2 & 1) op = multModP(x2n[k & 31], op);
+    }
+    return multModP(op, crc1) ^ crc2;
+  }
+
+private:
+
+  static const uint32_t Poly = 0x82f63b78;
+
+  /// product of two polynomials modulo the CRC polynomial, bit reflected
+  static uint32_t multModP(uint32_t a, uint32_t b) {
+    uint32_t m = 1u << 31;
+    uint32_t p = 0;
+    for (;;) {
+      if (a & m) {
+        p ^= b;
+        if (0 == (a & (m - 1))) break;
+      }
+      m >>= 1;
+      b = (b & 1) ? (b >> 1) ^ Poly : b >> 1;
+    }
+    return p;
+  }
+
+  /// x^(2^k) modulo the CRC polynomial, for k in [0, 32[
+  struct Powers {
+    Powers() {
+      x2n[0] = 1u << 30;
+      for (int k = 1; k < 32; k++) x2n[k] = multModP(x2n[k-1], x2n[k-1]);
+    }
+    uint32_t x2n[32];
+  };
+
+  static const Powers& powers() {
+    static const Powers powers;
+    return powers;
+  }
+
+};
+
+//------------------------------------------------------------------------------
+//! Computes the page checksums of data arriving in several consecutive parts,
+//! e.g. the buffers of a bufferlist, optionally copying them at the same time.
+//! Copies are done a page piece at a time and checksummed right after, while
+//! the data is still in the L1 cache, so that it is only brought in once
+//------------------------------------------------------------------------------
+
+class XrdCephPageCrc {
+
+public:
+
+  /// the data starts at the given file offset, checksums go to csvec
+  XrdCephPageCrc(off_t offset, uint32_t *csvec) :
+    m_offset(offset), m_csvec(csvec), m_crc(0), m_partial(false) {}
+
+  /// accounts for the next len bytes of data, copying them to dst if not null
+  void update(const char *src, size_t len, char *dst = 0) {
+    while (len > 0) {
+      size_t left = XrdOucPgrwUtils::pgPageSize - m_offset % XrdOucPgrwUtils::pgPageSize;
+      size_t n = len < left ? len : left;
+      if (dst) {
+        memcpy(dst, src, n);
+        m_crc = XrdOucCRC::Calc32C(dst, n, m_crc);
+        dst += n;
+      } else {
+        m_crc = XrdOucCRC::Calc32C(src, n, m_crc);
+      }
+      src += n;
+      len -= n;
+      m_offset += n;
+      m_partial = true;
+      if (n == left) flushPage();
+    }
+  }
+
+  /// stores the checksum of the last page if it was partial
+  void finish() {
+    if (m_partial) flushPage();
+  }
+
+private:
+
+  void flushPage() {
+    *m_csvec++ = m_crc;
+    m_crc = 0;
+    m_partial = false;
+  }
+
+  off_t m_offset;
+  uint32_t *m_csvec;
+  uint32_t m_crc;
+  bool m_partial;
+
+};
+
+#endif /* __XRD_CEPH_CRC32C_HH__ */
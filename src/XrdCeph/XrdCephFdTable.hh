@@ -0,0 +1,202 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// This file is part of the XRootD software suite.
+//
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//
+// In applying this licence, CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//------------------------------------------------------------------------------
+
+#ifndef __XRD_CEPH_FD_TABLE_HH__
+#define __XRD_CEPH_FD_TABLE_HH__
+
+#include <atomic>
+#include <vector>
+#include <errno.h>
+#include "XrdSys/XrdSysPthread.hh"
+
+//------------------------------------------------------------------------------
+//! Table of file descriptors used by XrdCephPosix.
+//!
+//! Descriptors index directly into a set of slots, so that a lookup is a couple
+//! of atomic loads and never takes a lock. Slots are spread over a fixed number
+//! of shards, each with its own mutex, and only insertion and removal take the
+//! shard mutex. Slot storage is allocated by chunks that are never released
+//! before the table itself is destroyed, so that a reader never sees memory
+//! going away under its feet.
+//!
+//! A descriptor carries the generation of its slot in its upper bits. Removal
+//! bumps the generation, so that a stale descriptor pointing to a reused slot
+//! is detected and rejected instead of silently hitting another file.
+//!
+//! The table does not own the objects it points to : remove returns the
+//! pointer and the caller is in charge of deleting it.
+//------------------------------------------------------------------------------
+
+template <typename T>
+class XrdCephFdTable {
+
+public:
+
+  /// number of shards, as a power of 2
+  static const unsigned int ShardBits = 4;
+  static const unsigned int NbShards = 1u << ShardBits;
+  /// number of slots allocated in one go, as a power of 2
+  static const unsigned int ChunkBits = 10;
+  static const unsigned int ChunkSize = 1u << ChunkBits;
+  /// maximum number of chunks per shard, as a power of 2
+  static const unsigned int MaxChunkBits = 6;
+  static const unsigned int MaxChunks = 1u << MaxChunkBits;
+  /// a descriptor is made of a slot index and a generation, and must remain
+  /// a positive int
+  static const unsigned int IndexBits = ShardBits + ChunkBits + MaxChunkBits;
+  static const unsigned int IndexMask = (1u << IndexBits) - 1;
+  static const unsigned int GenerationBits = 31 - IndexBits;
+  static const unsigned int GenerationMask = (1u << GenerationBits) - 1;
+  /// total capacity of the table
+  static const unsigned int MaxSlots = 1u << IndexBits;
+
+  XrdCephFdTable() : m_nextShard(0) {
+    for (unsigned int i = 0; i < NbShards; i++) {
+      m_shards[i].nbUsedSlots = 0;
+      for (unsigned int j = 0; j < MaxChunks; j++) {
+        m_shards[i].chunks[j].store(0, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  ~XrdCephFdTable() {
+    for (unsigned int i = 0; i < NbShards; i++) {
+      for (unsigned int j = 0; j < MaxChunks; j++) {
+        delete[] m_shards[i].chunks[j].load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// inserts a new object and returns its file descriptor,
+  /// or -EMFILE if the table is full
+  int insert(T *obj) {
+    unsigned int first = m_nextShard.fetch_add(1, std::memory_order_relaxed);
+    // try all shards, starting from the next one in round robin
+    for (unsigned int n = 0; n < NbShards; n++) {
+      unsigned int shardIdx = (first + n) & (NbShards - 1);
+      Shard &shard = m_shards[shardIdx];
+      XrdSysMutexHelper lock(shard.mutex);
+      unsigned int localIdx;
+      if (!shard.freeSlots.empty()) {
+        localIdx = shard.freeSlots.back();
+        shard.freeSlots.pop_back();
+      } else if (shard.nbUsedSlots < MaxChunks * ChunkSize) {
+        localIdx = shard.nbUsedSlots;
+        unsigned int chunkIdx = localIdx >> ChunkBits;
+        if (0 == shard.chunks[chunkIdx].load(std::memory_order_relaxed)) {
+          Slot *chunk = new Slot[ChunkSize];
+          for (unsigned int i = 0; i < ChunkSize; i++) {
+            chunk[i].obj.store(0, std::memory_order_relaxed);
+            chunk[i].generation.store(0, std::memory_order_relaxed);
+          }
+          shard.chunks[chunkIdx].store(chunk, std::memory_order_release);
+        }
+        shard.nbUsedSlots++;
+      } else {
+        continue;
+      }
+      Slot &slot = getSlot(shard, localIdx);
+      slot.obj.store(obj, std::memory_order_release);
+      unsigned int index = (localIdx << ShardBits) | shardIdx;
+      unsigned int generation = slot.generation.load(std::memory_order_relaxed);
+      return (int)((generation << IndexBits) | index);
+    }
+    return -EMFILE;
+  }
+
+  /// looks up the object associated to a file descriptor. Returns 0 if none.
+  /// This never blocks. Note that the object is not protected from deletion,
+  /// callers rely on the fact that close is never called concurrently with
+  /// other operations on the same descriptor.
+  T* get(int fd) const {
+    Slot *slot = lookupSlot(fd);
+    if (0 == slot) return 0;
+    T *obj = slot->obj.load(std::memory_order_acquire);
+    if (0 == obj ||
+        slot->generation.load(std::memory_order_acquire) != generationOf(fd)) {
+      return 0;
+    }
+    return obj;
+  }
+
+  /// removes the object associated to a file descriptor and returns it,
+  /// or returns 0 if the descriptor is not valid. The slot is recycled.
+  T* remove(int fd) {
+    Slot *slot = lookupSlot(fd);
+    if (0 == slot) return 0;
+    unsigned int index = fd & IndexMask;
+    Shard &shard = m_shards[index & (NbShards - 1)];
+    XrdSysMutexHelper lock(shard.mutex);
+    T *obj = slot->obj.load(std::memory_order_relaxed);
+    if (0 == obj ||
+        slot->generation.load(std::memory_order_relaxed) != generationOf(fd)) {
+      return 0;
+    }
+    slot->obj.store(0, std::memory_order_release);
+    slot->generation.store((generationOf(fd) + 1) & GenerationMask,
+                           std::memory_order_release);
+    shard.freeSlots.push_back(index >> ShardBits);
+    return obj;
+  }
+
+private:
+
+  struct Slot {
+    std::atomic<T*> obj;
+    std::atomic<unsigned int> generation;
+  };
+
+  /// each shard lives on its own cache lines so that insertions and removals
+  /// in different shards do not interfere
+  struct alignas(64) Shard {
+    XrdSysMutex mutex;
+    std::atomic<Slot*> chunks[MaxChunks];
+    std::vector<unsigned int> freeSlots;
+    unsigned int nbUsedSlots;
+  };
+
+  static unsigned int generationOf(int fd) {
+    return ((unsigned int)fd >> IndexBits) & GenerationMask;
+  }
+
+  static Slot& getSlot(Shard &shard, unsigned int localIdx) {
+    Slot *chunk = shard.chunks[localIdx >> ChunkBits].load(std::memory_order_acquire);
+    return chunk[localIdx & (ChunkSize - 1)];
+  }
+
+  Slot* lookupSlot(int fd) const {
+    if (fd < 0) return 0;
+    unsigned int index = fd & IndexMask;
+    unsigned int localIdx = index >> ShardBits;
+    const Shard &shard = m_shards[index & (NbShards - 1)];
+    Slot *chunk = shard.chunks[localIdx >> ChunkBits].load(std::memory_order_acquire);
+    if (0 == chunk) return 0;
+    return &chunk[localIdx & (ChunkSize - 1)];
+  }
+
+  Shard m_shards[NbShards];
+  std::atomic<unsigned int> m_nextShard;
+
+};
+
+#endif /* __XRD_CEPH_FD_TABLE_HH__ */
@@ -0,0 +1,291 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// This file is part of the XRootD software suite.
+//
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//
+// In applying this licence, CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//------------------------------------------------------------------------------
+
+#ifndef __XRD_CEPH_HEDGE_HH__
+#define __XRD_CEPH_HEDGE_HH__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+//------------------------------------------------------------------------------
+//! Lock free histogram of latencies in microseconds, with buckets of a
+//! quarter of an octave (about 19% wide), giving cheap percentiles.
+//! Counts are halved every DecayCount samples so that percentiles follow
+//! the current behaviour of the cluster.
+//------------------------------------------------------------------------------
+
+class XrdCephLatencyHistogram {
+
+public:
+
+  static const unsigned int NbBuckets = 4 * 40;
+  static const uint64_t DecayCount = 1 << 16;
+
+  XrdCephLatencyHistogram() : m_count(0) {
+    for (unsigned int i = 0; i < NbBuckets; i++) m_buckets[i] = 0;
+  }
+
+  void record(uint64_t us) {
+    m_buckets[bucket(us)]++;
+    if (++m_count == DecayCount) {
+      // only the thread reaching the threshold decays, concurrent records
+      // are merely approximated
+      uint64_t total = 0;
+      for (unsigned int i = 0; i < NbBuckets; i++) {
+        uint64_t v = m_buckets[i] / 2;
+        m_buckets[i] = v;
+        total += v;
+      }
+      m_count = total;
+    }
+  }
+
+  uint64_t count() const { return m_count; }
+
+  /// upper bound of the bucket holding the given percentile (0 to 100)
+  uint64_t percentile(double p) const {
+    uint64_t counts[NbBuckets];
+    uint64_t total = 0;
+    for (unsigned int i = 0; i < NbBuckets; i++) {
+      counts[i] = m_buckets[i];
+      total += counts[i];
+    }
+    if (0 == total) return 0;
+    uint64_t rank = (uint64_t)(total * p / 100.0);
+    uint64_t seen = 0;
+    for (unsigned int i = 0; i < NbBuckets; i++) {
+      seen += counts[i];
+      if (seen > rank) return upperBound(i);
+    }
+    return upperBound(NbBuckets - 1);
+  }
+
+  /// bucket of a latency : 4 per power of 2, from the 2 bits after the top one
+  static unsigned int bucket(uint64_t us) {
+    if (us < 4) return us;
+    unsigned int log = 63 - __builtin_clzll(us);
+    unsigned int b = 4 * (log - 1) + ((us >> (log - 2)) & 3);
+    return b < NbBuckets ? b : NbBuckets - 1;
+  }
+
+  /// largest latency falling in a bucket
+  static uint64_t upperBound(unsigned int b) {
+    if (b < 4) return b;
+    unsigned int log = b / 4 + 1;
+    return ((4ull + (b & 3) + 1) << (log - 2)) - 1;
+  }
+
+private:
+
+  std::atomic<uint64_t> m_buckets[NbBuckets];
+  std::atomic<uint64_t> m_count;
+};
+
+//------------------------------------------------------------------------------
+//! A request that may be hedged : when not done by its deadline, a second
+//! attempt is issued and the first attempt to succeed wins. A failed attempt
+//! only wins when no other one is in flight, so that the request fails only
+//! if all its attempts did. Requests are shared, so that the losing attempt
+//! can still complete safely.
+//------------------------------------------------------------------------------
+
+class XrdCephHedged : public std::enable_shared_from_this<XrdCephHedged> {
+
+public:
+
+  /// the first attempt is in flight from the creation of the request
+  XrdCephHedged() : m_done(false), m_inFlight(1) {}
+  virtual ~XrdCephHedged() {}
+
+  /// issues the second attempt. Called at most once, by the watchdog
+  virtual void hedge() = 0;
+
+  /// to be called by each attempt when it is over. Returns true for the one
+  /// completing the request, which is then done
+  bool finish(bool failed) {
+    unsigned int left = --m_inFlight;
+    if (failed && left > 0) return false;
+    bool expected = false;
+    return m_done.compare_exchange_strong(expected, true);
+  }
+
+  bool done() const { return m_done; }
+
+private:
+
+  friend class XrdCephHedger;
+
+  std::atomic<bool> m_done;
+  std::atomic<unsigned int> m_inFlight;
+};
+
+//------------------------------------------------------------------------------
+//! Deadline policy and watchdog of hedged requests.
+//!
+//! The deadline of a request is the configured percentile of the latencies
+//! of first attempts, clamped to [minDelay, maxDelay], so that only the
+//! slowest requests get hedged and the extra load stays bounded.
+//! A single thread sleeps until the earliest deadline and hedges the
+//! requests still not done. It is started on first use. Tests can give
+//! their own clock and no watchdog, and call poll() as their time goes by.
+//------------------------------------------------------------------------------
+
+class XrdCephHedger {
+
+public:
+
+  typedef std::chrono::steady_clock Clock;
+  typedef Clock::time_point (*NowFunc)();
+
+  XrdCephHedger(NowFunc now = &Clock::now, bool watchdog = true) :
+    m_now(now), m_watchdog(watchdog), m_percentile(0), m_minDelay(1000),
+    m_maxDelay(1000000), m_stop(false), m_issued(0), m_won(0) {}
+
+  ~XrdCephHedger() { stop(); }
+
+  /// enables hedging at the given percentile (0 disables it). Not thread
+  /// safe, to be called at configuration time
+  void configure(double percentile, uint64_t minDelayUs, uint64_t maxDelayUs) {
+    m_percentile = percentile;
+    m_minDelay = minDelayUs;
+    m_maxDelay = maxDelayUs > minDelayUs ? maxDelayUs : minDelayUs;
+  }
+
+  bool enabled() const { return m_percentile > 0; }
+
+  /// records the latency of a first attempt
+  void record(uint64_t us) { m_latencies.record(us); }
+
+  /// current hedging delay in microseconds. Until enough latencies are
+  /// known, the maximal delay is used
+  uint64_t delay() const {
+    if (m_latencies.count() < MinSamples) return m_maxDelay;
+    uint64_t d = m_latencies.percentile(m_percentile);
+    return d < m_minDelay ? m_minDelay : (d > m_maxDelay ? m_maxDelay : d);
+  }
+
+  /// arms the watchdog for a request whose first attempt was just issued
+  void watch(const std::shared_ptr<XrdCephHedged> &request) {
+    Clock::time_point deadline = m_now() + std::chrono::microseconds(delay());
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_stop) return;
+    if (m_watchdog && !m_thread.joinable()) {
+      m_thread = std::thread(&XrdCephHedger::run, this);
+    }
+    bool earliest = m_queue.empty() || deadline < m_queue.top().deadline;
+    m_queue.push(Entry{deadline, request});
+    if (earliest) m_cond.notify_one();
+  }
+
+  /// stops the watchdog, pending requests are not hedged anymore
+  void stop() {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_stop = true;
+      m_queue = std::priority_queue<Entry, std::vector<Entry>, Later>();
+      m_cond.notify_one();
+    }
+    if (m_thread.joinable()) m_thread.join();
+  }
+
+  /// hedges the requests whose deadline passed
+  void poll() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop && !m_queue.empty() && m_queue.top().deadline <= m_now()) {
+      hedgeFirst(lock);
+    }
+  }
+
+  /// to be called by the second attempt when it won
+  void won() { m_won++; }
+
+  unsigned long long issued() const { return m_issued; }
+  unsigned long long wins() const { return m_won; }
+
+private:
+
+  static const uint64_t MinSamples = 100;
+
+  struct Entry {
+    Clock::time_point deadline;
+    std::shared_ptr<XrdCephHedged> request;
+  };
+
+  struct Later {
+    bool operator()(const Entry &a, const Entry &b) const { return a.deadline > b.deadline; }
+  };
+
+  void run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+      if (m_queue.empty()) {
+        m_cond.wait(lock);
+        continue;
+      }
+      Clock::time_point deadline = m_queue.top().deadline;
+      if (m_now() < deadline) {
+        m_cond.wait_until(lock, deadline);
+        continue;
+      }
+      hedgeFirst(lock);
+    }
+  }
+
+  /// hedges the request with the earliest deadline if it is not done
+  void hedgeFirst(std::unique_lock<std::mutex> &lock) {
+    std::shared_ptr<XrdCephHedged> request = m_queue.top().request;
+    m_queue.pop();
+    if (request->done()) return;
+    m_issued++;
+    // accounted before the attempt exists, so that a failure of the first
+    // attempt meanwhile waits for it
+    request->m_inFlight++;
+    // hedging submits I/O, do not hold the lock meanwhile
+    lock.unlock();
+    request->hedge();
+    lock.lock();
+  }
+
+  NowFunc m_now;
+  bool m_watchdog;
+  XrdCephLatencyHistogram m_latencies;
+  double m_percentile;
+  uint64_t m_minDelay;
+  uint64_t m_maxDelay;
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  std::priority_queue<Entry, std::vector<Entry>, Later> m_queue;
+  std::thread m_thread;
+  bool m_stop;
+  std::atomic<unsigned long long> m_issued;
+  std::atomic<unsigned long long> m_won;
+};
+
+#endif // __XRD_CEPH_HEDGE_HH__
@@ -0,0 +1,254 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// This file is part of the XRootD software suite.
+//
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//
+// In applying this licence, CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//------------------------------------------------------------------------------
+
+#ifndef __XRD_CEPH_LAYOUT_TABLE_HH__
+#define __XRD_CEPH_LAYOUT_TABLE_HH__
+
+#include <atomic>
+#include <string>
+#include <string.h>
+#include "XrdSys/XrdSysPthread.hh"
+
+//------------------------------------------------------------------------------
+//! Interning of short strings (userIds and pools) into small integers.
+//!
+//! Lookups of existing strings are wait-free : entries are only ever appended
+//! and published through an atomic counter. Only the addition of a new string
+//! takes a mutex. The capacity is fixed, as the number of distinct users and
+//! pools used by a server is expected to be tiny.
+//------------------------------------------------------------------------------
+
+class XrdCephStringInterner {
+
+public:
+
+  static const unsigned int Capacity = 256;
+  static const unsigned int Invalid = ~0u;
+
+  XrdCephStringInterner() : m_size(0) {}
+
+  ~XrdCephStringInterner() {
+    unsigned int size = m_size.load(std::memory_order_relaxed);
+    for (unsigned int i = 0; i < size; i++) delete m_entries[i].str;
+  }
+
+  /// returns the index of the given string, adding it if needed
+  /// Returns Invalid if the interner is full
+  unsigned int intern(const char *s, size_t len) {
+    unsigned long long h = hash(s, len);
+    unsigned int idx = find(s, len, h);
+    if (Invalid != idx) return idx;
+    XrdSysMutexHelper lock(m_mutex);
+    unsigned int size = m_size.load(std::memory_order_relaxed);
+    // double check now that we have the lock
+    idx = find(s, len, h);
+    if (Invalid != idx) return idx;
+    if (size >= Capacity) return Invalid;
+    m_entries[size].hash = h;
+    m_entries[size].str = new std::string(s, len);
+    m_size.store(size + 1, std::memory_order_release);
+    return size;
+  }
+
+  unsigned int intern(const std::string &s) {
+    return intern(s.c_str(), s.size());
+  }
+
+  /// FNV-1a hash
+  static unsigned long long hash(const char *s, size_t len) {
+    unsigned long long h = 14695981039346656037ULL;
+    for (size_t i = 0; i < len; i++) {
+      h ^= (unsigned char)s[i];
+      h *= 1099511628211ULL;
+    }
+    return h;
+  }
+
+private:
+
+  unsigned int find(const char *s, size_t len, unsigned long long h) const {
+    unsigned int size = m_size.load(std::memory_order_acquire);
+    for (unsigned int i = 0; i < size; i++) {
+      const Entry &e = m_entries[i];
+      if (e.hash == h && e.str->size() == len && 0 == memcmp(e.str->c_str(), s, len)) {
+        return i;
+      }
+    }
+    return Invalid;
+  }
+
+  struct Entry {
+    unsigned long long hash;
+    const std::string *str;
+  };
+
+  Entry m_entries[Capacity];
+  std::atomic<unsigned int> m_size;
+  XrdSysMutex m_mutex;
+
+};
+
+//------------------------------------------------------------------------------
+//! Compact key identifying a ceph file layout : interned userId and pool,
+//! followed by the striping parameters. The hash is computed once at creation.
+//------------------------------------------------------------------------------
+
+struct XrdCephLayoutKey {
+
+  unsigned int userId;
+  unsigned int pool;
+  unsigned int nbStripes;
+  unsigned long long stripeUnit;
+  unsigned long long objectSize;
+  unsigned long long hash;
+
+  /// builds a key. Returns false if the strings could not be interned
+  static bool make(XrdCephStringInterner &interner, const std::string &userId,
+                   const std::string &pool, unsigned int nbStripes,
+                   unsigned long long stripeUnit, unsigned long long objectSize,
+                   XrdCephLayoutKey &key) {
+    key.userId = interner.intern(userId);
+    key.pool = interner.intern(pool);
+    if (XrdCephStringInterner::Invalid == key.userId ||
+        XrdCephStringInterner::Invalid == key.pool) {
+      return false;
+    }
+    key.nbStripes = nbStripes;
+    key.stripeUnit = stripeUnit;
+    key.objectSize = objectSize;
+    unsigned long long h = ((unsigned long long)key.userId << 32) | key.pool;
+    h = mix(h ^ nbStripes);
+    h = mix(h ^ stripeUnit);
+    key.hash = mix(h ^ objectSize);
+    return true;
+  }
+
+  bool operator==(const XrdCephLayoutKey &o) const {
+    return hash == o.hash && userId == o.userId && pool == o.pool &&
+      nbStripes == o.nbStripes && stripeUnit == o.stripeUnit && objectSize == o.objectSize;
+  }
+
+  /// splitmix64 finalizer
+  static unsigned long long mix(unsigned long long h) {
+    h += 0x9e3779b97f4a7c15ULL;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+  }
+
+};
+
+//------------------------------------------------------------------------------
+//! Open addressing table of per layout objects, keyed by XrdCephLayoutKey.
+//!
+//! Entries are never removed before the table is cleared, so that lookups of
+//! existing entries are wait-free. Creation of a missing entry is serialized
+//! through the table mutex, which callers may also use to protect other
+//! per-table state (e.g. the underlying cluster connection).
+//------------------------------------------------------------------------------
+
+template <typename V>
+class XrdCephLayoutTable {
+
+public:
+
+  /// maximum number of layouts, as a power of 2
+  static const unsigned int Capacity = 1024;
+
+  XrdCephLayoutTable() {
+    for (unsigned int i = 0; i < Capacity; i++) {
+      m_entries[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  ~XrdCephLayoutTable() { clear(); }
+
+  /// finds an existing entry, returns 0 if none. This is wait-free
+  V* find(const XrdCephLayoutKey &key) const {
+    for (unsigned int n = 0; n < Capacity; n++) {
+      Entry *e = m_entries[(key.hash + n) & (Capacity - 1)].load(std::memory_order_acquire);
+      if (0 == e) return 0;
+      if (e->key == key) return &e->value;
+    }
+    return 0;
+  }
+
+  /// finds an existing entry or creates it by calling create(V&), which should
+  /// return true on success. Returns 0 if creation failed or the table is full
+  template <typename Creator>
+  V* findOrCreate(const XrdCephLayoutKey &key, Creator create) {
+    V *v = find(key);
+    if (v) return v;
+    XrdSysMutexHelper lock(m_mutex);
+    // double check now that we have the lock
+    v = find(key);
+    if (v) return v;
+    for (unsigned int n = 0; n < Capacity; n++) {
+      std::atomic<Entry*> &slot = m_entries[(key.hash + n) & (Capacity - 1)];
+      if (0 == slot.load(std::memory_order_relaxed)) {
+        Entry *e = new Entry(key);
+        if (!create(e->value)) {
+          delete e;
+          return 0;
+        }
+        slot.store(e, std::memory_order_release);
+        return &e->value;
+      }
+    }
+    return 0;
+  }
+
+  /// calls f(V&) for all entries. Must not be called concurrently with creations
+  template <typename F>
+  void forEach(F f) {
+    for (unsigned int i = 0; i < Capacity; i++) {
+      Entry *e = m_entries[i].load(std::memory_order_acquire);
+      if (e) f(e->value);
+    }
+  }
+
+  /// drops all entries. Must not be called concurrently with any other method
+  void clear() {
+    for (unsigned int i = 0; i < Capacity; i++) {
+      delete m_entries[i].load(std::memory_order_relaxed);
+      m_entries[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /// mutex serializing creations
+  XrdSysMutex& mutex() { return m_mutex; }
+
+private:
+
+  struct Entry {
+    Entry(const XrdCephLayoutKey &k) : key(k), value() {}
+    XrdCephLayoutKey key;
+    V value;
+  };
+
+  std::atomic<Entry*> m_entries[Capacity];
+  XrdSysMutex m_mutex;
+
+};
+
+#endif /* __XRD_CEPH_LAYOUT_TABLE_HH__ */
@@ -24,6 +24,7 @@
 
 #include <stdio.h>
 #include <string>
+#include <vector>
 #include <fcntl.h>
 
 #include "XrdCeph/XrdCephPosix.hh"
@@ -102,12 +103,24 @@ XrdCephOss::~XrdCephOss() {
 
 // declared and used in XrdCephPosix.cc
 extern unsigned int g_maxCephPoolIdx;
+extern unsigned int g_cephPoolReportInterval;
+extern unsigned int g_readAheadWindow;
+extern unsigned long long g_readAheadBudget;
+extern bool g_directReads;
+extern bool g_sparseReads;
+extern bool g_fastCreate;
+extern unsigned int g_aioCoalesceWindow;
+extern unsigned long long g_aioCoalesceGap;
+extern unsigned int g_fsyncTimeout;
 int XrdCephOss::Configure(const char *configfn, XrdSysError &Eroute) {
    int NoGo = 0;
    XrdOucEnv myEnv;
    XrdOucStream Config(&Eroute, getenv("XRDINSTANCE"), &myEnv, "=====> ");
    //disable posc  
    XrdOucEnv::Export("XRDXROOTD_NOPOSC", "1");
+   // layouts to be warmed up if ceph.warmup is given
+   bool warmup = false;
+   std::vector<std::string> warmupLayouts;
    // If there is no config file, nothing to be done
    if (configfn && *configfn) {
      // Try to open the configuration file.
@@ -156,6 +169,244 @@ int XrdCephOss::Configure(const char *configfn, XrdSysError &Eroute) {
            return 1;
          }
        }
+       if (!strncmp(var, "ceph.connectionpolicy", 21)) {
+         var = Config.GetWord();
+         if (var) {
+           if (ceph_posix_set_pool_policy(var)) {
+             Eroute.Emsg("Config", "Invalid value for ceph.connectionpolicy in config file "
+                         "(must be roundrobin, leastoutstanding or poweroftwo)", configfn, var);
+             return 1;
+           }
+         } else {
+           Eroute.Emsg("Config", "Missing value for ceph.connectionpolicy in config file", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.connectionreport", 21)) {
+         var = Config.GetWord();
+         if (var) {
+           g_cephPoolReportInterval = strtoul(var, 0, 10);
+         } else {
+           Eroute.Emsg("Config", "Missing value for ceph.connectionreport in config file", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.fstatmode", 14)) {
+         var = Config.GetWord();
+         if (var) {
+           if (ceph_posix_set_fstat_mode(var)) {
+             Eroute.Emsg("Config", "Invalid value for ceph.fstatmode in config file "
+                         "(must be local or cluster)", configfn, var);
+             return 1;
+           }
+         } else {
+           Eroute.Emsg("Config", "Missing value for ceph.fstatmode in config file", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.readahead", 14)) {
+         var = Config.GetWord();
+         if (var) {
+           g_readAheadWindow = strtoul(var, 0, 10);
+           // optional memory budget, in MB
+           char *budgetVar = Config.GetWord();
+           if (budgetVar) {
+             unsigned long long budget = strtoull(budgetVar, 0, 10);
+             if (0 == budget) {
+               Eroute.Emsg("Config", "Invalid budget for ceph.readahead in config file (must be a positive number of MB)", configfn, budgetVar);
+               return 1;
+             }
+             g_readAheadBudget = budget * 1024 * 1024;
+           }
+         } else {
+           Eroute.Emsg("Config", "Missing value for ceph.readahead in config file", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.blockcache", 15)) {
+         var = Config.GetWord();
+         if (var) {
+           // size in MB, 0 disables the cache
+           ceph_posix_set_block_cache(strtoull(var, 0, 10) * 1024 * 1024);
+         } else {
+           Eroute.Emsg("Config", "Missing value for ceph.blockcache in config file", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.directreads", 16)) {
+         var = Config.GetWord();
+         if (var && (!strcmp(var, "on") || !strcmp(var, "off"))) {
+           g_directReads = !strcmp(var, "on");
+         } else {
+           Eroute.Emsg("Config", "Missing or invalid value for ceph.directreads in config file (must be on or off)", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.sparsereads", 16)) {
+         var = Config.GetWord();
+         if (var && (!strcmp(var, "on") || !strcmp(var, "off"))) {
+           g_sparseReads = !strcmp(var, "on");
+         } else {
+           Eroute.Emsg("Config", "Missing or invalid value for ceph.sparsereads in config file (must be on or off)", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.fastcreate", 15)) {
+         var = Config.GetWord();
+         if (var && (!strcmp(var, "on") || !strcmp(var, "off"))) {
+           g_fastCreate = !strcmp(var, "on");
+         } else {
+           Eroute.Emsg("Config", "Missing or invalid value for ceph.fastcreate in config file (must be on or off)", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.layoutrule", 15)) {
+         // path prefix, size hint range, then nbStripes,stripeUnit,objectSize
+         var = Config.GetWord();
+         std::string prefix = var ? var : "";
+         char *sizesVar = var ? Config.GetWord() : 0;
+         std::string sizes = sizesVar ? sizesVar : "";
+         char *layoutVar = sizesVar ? Config.GetWord() : 0;
+         if (!layoutVar || ceph_posix_add_layout_rule(prefix.c_str(), sizes.c_str(), layoutVar)) {
+           Eroute.Emsg("Config", "Missing or invalid value for ceph.layoutrule in config file "
+                       "(expected <prefix> *|[<min>]-[<max>] <nbStripes>,<stripeUnit>,<objectSize>)", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.openprefetch", 17)) {
+         // path prefix, then head and optional tail sizes in KB
+         var = Config.GetWord();
+         std::string prefix = var ? var : "";
+         char *headVar = var ? Config.GetWord() : 0;
+         if (headVar) {
+           std::string head = headVar;
+           char *tailVar = Config.GetWord();
+           if (ceph_posix_add_open_prefetch(prefix.c_str(), head.c_str(), tailVar)) {
+             Eroute.Emsg("Config", "Invalid value for ceph.openprefetch in config file "
+                         "(sizes must be numbers of KB)", configfn);
+             return 1;
+           }
+         } else {
+           Eroute.Emsg("Config", "Missing value for ceph.openprefetch in config file "
+                       "(expected <pathPrefix> <headKB> [<tailKB>])", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.writebehind", 16)) {
+         // chunk size, then optional memory cap in MB and overflow policy
+         var = Config.GetWord();
+         if (var) {
+           std::string chunk = var;
+           char *capVar = Config.GetWord();
+           unsigned long long capacity = capVar ? strtoull(capVar, 0, 10) * 1024 * 1024 : 0;
+           char *overflowVar = capVar ? Config.GetWord() : 0;
+           if (ceph_posix_set_write_behind(chunk.c_str(), capacity, overflowVar)) {
+             Eroute.Emsg("Config", "Invalid value for ceph.writebehind in config file "
+                         "(expected off|stripeunit|objectset [<capMB> [direct|wait]])", configfn);
+             return 1;
+           }
+         } else {
+           Eroute.Emsg("Config", "Missing value for ceph.writebehind in config file", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.aiowritelimits", 19)) {
+         // per file MB and ops, global MB and ops (0 for unlimited), then
+         // optional overflow policy
+         unsigned long long values[4];
+         unsigned int nbValues = 0;
+         while (nbValues < 4 && (var = Config.GetWord())) {
+           values[nbValues++] = strtoull(var, 0, 10);
+         }
+         char *overflowVar = nbValues == 4 ? Config.GetWord() : 0;
+         if (nbValues < 4 ||
+             ceph_posix_set_aio_write_limits(values[0] * 1024 * 1024, values[1],
+                                             values[2] * 1024 * 1024, values[3], overflowVar)) {
+           Eroute.Emsg("Config", "Missing or invalid value for ceph.aiowritelimits in config file "
+                       "(expected <fileMB> <fileOps> <globalMB> <globalOps> [block|sync])", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.fsynctimeout", 17)) {
+         var = Config.GetWord();
+         if (var) {
+           // in seconds, 0 waits for as long as needed
+           g_fsyncTimeout = strtoul(var, 0, 10);
+         } else {
+           Eroute.Emsg("Config", "Missing value for ceph.fsynctimeout in config file", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.streamingcks", 17)) {
+         var = Config.GetWord();
+         if (!var) {
+           Eroute.Emsg("Config", "Missing value for ceph.streamingcks in config file", configfn);
+           return 1;
+         }
+         // one or more algorithms, computed while files are written
+         for (char *alg = var; alg; alg = Config.GetWord()) {
+           if (ceph_posix_set_streaming_checksum(alg)) {
+             Eroute.Emsg("Config", "Invalid value for ceph.streamingcks in config file "
+                         "(must be adler32 and/or crc32c)", configfn, alg);
+             return 1;
+           }
+         }
+       }
+       if (!strncmp(var, "ceph.readmode", 13)) {
+         var = Config.GetWord();
+         if (var) {
+           if (ceph_posix_set_read_mode(var)) {
+             Eroute.Emsg("Config", "Invalid value for ceph.readmode in config file "
+                         "(must be primary, balance or localize)", configfn, var);
+             return 1;
+           }
+         } else {
+           Eroute.Emsg("Config", "Missing value for ceph.readmode in config file", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.hedgedreads", 16)) {
+         var = Config.GetWord();
+         if (var) {
+           // percentile of the read latencies after which a read is hedged,
+           // then optional minimal and maximal delays in microseconds
+           double percentile = strtod(var, 0);
+           if (percentile < 0 || percentile >= 100) {
+             Eroute.Emsg("Config", "Invalid value for ceph.hedgedreads in config file "
+                         "(percentile must be in [0, 100[)", configfn, var);
+             return 1;
+           }
+           unsigned long long minDelay = 1000, maxDelay = 1000000;
+           char *delayVar = Config.GetWord();
+           if (delayVar) {
+             minDelay = strtoull(delayVar, 0, 10);
+             delayVar = Config.GetWord();
+             if (delayVar) maxDelay = strtoull(delayVar, 0, 10);
+           }
+           ceph_posix_set_hedged_reads(percentile, minDelay, maxDelay);
+         } else {
+           Eroute.Emsg("Config", "Missing value for ceph.hedgedreads in config file", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.aiocoalesce", 16)) {
+         var = Config.GetWord();
+         if (var) {
+           // window in microseconds, then optional maximal gap in bytes
+           g_aioCoalesceWindow = strtoul(var, 0, 10);
+           char *gapVar = Config.GetWord();
+           if (gapVar) g_aioCoalesceGap = strtoull(gapVar, 0, 10);
+         } else {
+           Eroute.Emsg("Config", "Missing value for ceph.aiocoalesce in config file", configfn);
+           return 1;
+         }
+       }
+       if (!strncmp(var, "ceph.warmup", 11)) {
+         warmup = true;
+         while ((var = Config.GetWord())) {
+           warmupLayouts.push_back(var);
+         }
+       }
      }
 
      // Now check if any errors occured during file i/o
@@ -166,6 +417,19 @@ int XrdCephOss::Configure(const char *configfn, XrdSysError &Eroute) {
      }
      Config.Close();
    }
+   // Connect to the cluster now rather than on first requests if asked to
+   if (warmup && !NoGo) {
+     try {
+       int nbFailures = ceph_posix_warmup(warmupLayouts);
+       if (nbFailures) {
+         Eroute.Say("Config warning: ceph.warmup failed for some connections, "
+                    "they will be retried on first use");
+       }
+     } catch (std::exception &e) {
+       Eroute.Emsg("Config", "Invalid layout given in ceph.warmup in config file", configfn);
+       return 1;
+     }
+   }
    return NoGo;
 }
 
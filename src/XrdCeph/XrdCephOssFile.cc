@@ -32,6 +32,7 @@
 #include "XrdSfs/XrdSfsAio.hh"
 
 #include "XrdCeph/XrdCephOssFile.hh"
+#include "XrdOuc/XrdOucPgrwUtils.hh"
 #include "XrdCeph/XrdCephOss.hh"
 
 extern XrdSysError XrdCephEroute;
@@ -75,6 +76,26 @@ ssize_t XrdCephOssFile::ReadRaw(void *buff, off_t offset, size_t blen) {
   return Read(buff, offset, blen);
 }
 
+ssize_t XrdCephOssFile::pgRead(void *buffer, off_t offset, size_t rdlen, uint32_t *csvec, uint64_t opts) {
+  return ceph_posix_pgread(m_fd, buffer, rdlen, offset, csvec);
+}
+
+static void aioPgReadCallback(XrdSfsAio *aiop, size_t rc) {
+  if ((ssize_t)rc > 0 && aiop->cksVec) {
+    XrdOucPgrwUtils::csCalc((const char*)aiop->sfsAio.aio_buf, aiop->sfsAio.aio_offset, rc, aiop->cksVec);
+  }
+  aiop->Result = rc;
+  aiop->doneRead();
+}
+
+int XrdCephOssFile::pgRead(XrdSfsAio *aiop, uint64_t opts) {
+  return ceph_aio_read(m_fd, aiop, aioPgReadCallback);
+}
+
+ssize_t XrdCephOssFile::ReadV(XrdOucIOVec *readV, int n) {
+  return ceph_posix_readv(m_fd, readV, n);
+}
+
 int XrdCephOssFile::Fstat(struct stat *buff) {
   return ceph_posix_fstat(m_fd, buff);
 }
@@ -92,6 +113,38 @@ int XrdCephOssFile::Write(XrdSfsAio *aiop) {
   return ceph_aio_write(m_fd, aiop, aioWriteCallback);
 }
 
+/// verifies or computes the page checksums of data to be written,
+/// depending on opts. Returns -EDOM if the verification fails
+static int pgWriteChecksums(const void *buffer, off_t offset, size_t wrlen,
+                            uint32_t *csvec, uint64_t opts) {
+  if (0 == csvec) return 0;
+  if (opts & XrdOssDF::Verify) {
+    XrdOucPgrwUtils::dataInfo dInfo((const char*)buffer, csvec, offset, wrlen);
+    off_t badOffset;
+    int badLen;
+    if (!XrdOucPgrwUtils::csVer(dInfo, badOffset, badLen)) {
+      XrdCephEroute.Say("pgWrite : checksum mismatch at offset ", std::to_string(badOffset).c_str());
+      return -EDOM;
+    }
+  } else if (opts & XrdOssDF::doCalc) {
+    XrdOucPgrwUtils::csCalc((const char*)buffer, offset, wrlen, csvec);
+  }
+  return 0;
+}
+
+ssize_t XrdCephOssFile::pgWrite(void *buffer, off_t offset, size_t wrlen, uint32_t *csvec, uint64_t opts) {
+  int rc = pgWriteChecksums(buffer, offset, wrlen, csvec, opts);
+  if (rc) return rc;
+  return ceph_posix_pwrite(m_fd, buffer, wrlen, offset);
+}
+
+int XrdCephOssFile::pgWrite(XrdSfsAio *aiop, uint64_t opts) {
+  int rc = pgWriteChecksums((const void*)aiop->sfsAio.aio_buf, aiop->sfsAio.aio_offset,
+                            aiop->sfsAio.aio_nbytes, aiop->cksVec, opts);
+  if (rc) return rc;
+  return ceph_aio_write(m_fd, aiop, aioWriteCallback);
+}
+
 int XrdCephOssFile::Fsync() {
   return ceph_posix_fsync(m_fd);
 }
@@ -61,9 +61,14 @@ public:
   virtual ssize_t Read(void *buff, off_t offset, size_t blen);
   virtual int     Read(XrdSfsAio *aoip);
   virtual ssize_t ReadRaw(void *, off_t, size_t);
+  virtual ssize_t ReadV(XrdOucIOVec *readV, int n);
+  virtual ssize_t pgRead(void *buffer, off_t offset, size_t rdlen, uint32_t *csvec, uint64_t opts);
+  virtual int     pgRead(XrdSfsAio *aioparm, uint64_t opts);
   virtual int Fstat(struct stat *buff);
   virtual ssize_t Write(const void *buff, off_t offset, size_t blen);
   virtual int Write(XrdSfsAio *aiop);
+  virtual ssize_t pgWrite(void *buffer, off_t offset, size_t wrlen, uint32_t *csvec, uint64_t opts);
+  virtual int     pgWrite(XrdSfsAio *aioparm, uint64_t opts);
   virtual int Fsync(void);
   virtual int Ftruncate(unsigned long long);
 
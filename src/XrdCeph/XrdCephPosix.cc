@@ -44,12 +44,27 @@
 #include <chrono>
 #include <limits>
 #include <pthread.h>
+#include <thread>
+#include <atomic>
+#include <deque>
+#include <new>
+#include <unordered_set>
 #include "XrdSfs/XrdSfsAio.hh"
 #include "XrdSys/XrdSysPthread.hh"
 #include "XrdOuc/XrdOucName2Name.hh"
 #include "XrdSys/XrdSysPlatform.hh"
 
 #include "XrdCeph/XrdCephPosix.hh"
+#include "XrdCeph/XrdCephFdTable.hh"
+#include "XrdCeph/XrdCephLayoutTable.hh"
+#include "XrdCeph/XrdCephStripeLayout.hh"
+#include "XrdCeph/XrdCephBlockCache.hh"
+#include "XrdCeph/XrdCephCommittedRanges.hh"
+#include "XrdCeph/XrdCephCrc32c.hh"
+#include "XrdCeph/XrdCephHedge.hh"
+#include "XrdCeph/XrdCephAdler32.hh"
+#include "XrdCks/XrdCksData.hh"
+#include "XrdOuc/XrdOucIOVec.hh"
 
 /// small structs to store file metadata
 struct CephFile {
@@ -61,26 +76,203 @@ struct CephFile {
   unsigned long long objectSize;
 };
 
+/// a block of a file prefetched by the readahead engine. It is referenced
+/// by the readahead window of its file and by its pending completion, and
+/// deleted when both are gone
+struct ReadAheadBlock {
+  ReadAheadBlock(uint64_t o, uint64_t l, unsigned int idx) :
+    offset(o), len(l), completion(0), cephPoolIdx(idx), refs(1) {}
+  ~ReadAheadBlock();
+  uint64_t offset;
+  uint64_t len;
+  ceph::bufferlist bl;
+  librados::AioCompletion *completion;
+  unsigned int cephPoolIdx;
+  std::atomic<int> refs;
+};
+
+/// per file state of the readahead engine
+struct ReadAheadState {
+  ReadAheadState() : nextOffset(0), seqCount(0), blockSize(0) {}
+  XrdSysMutex mutex;
+  // offset expected for the next read if the access is sequential
+  uint64_t nextOffset;
+  // number of consecutive sequential reads
+  unsigned int seqCount;
+  // size of the prefetched blocks, 0 if not yet known, ~0 if unusable
+  uint64_t blockSize;
+  // blocks prefetched or being prefetched, ordered and contiguous
+  std::deque<ReadAheadBlock*> window;
+};
+
+struct ObjectReadRequest;
+
+/// head and tail of a file prefetched at open
+struct OpenPrefetch {
+  OpenPrefetch() : tailOffset(0), tailLen(0), tail(0), tailRequest(0), tailDone(false),
+                   tailCond(0) {}
+  // first bytes of the file, read together with its metadata
+  ceph::bufferlist head;
+  // last tailLen bytes of the file, starting at tailOffset, read from their
+  // objects by tailRequest right after the metadata. Only usable once
+  // tailDone is set, which is signaled through tailCond
+  uint64_t tailOffset;
+  uint64_t tailLen;
+  char *tail;
+  ObjectReadRequest *tailRequest;
+  std::atomic<bool> tailDone;
+  XrdSysCondVar tailCond;
+};
+
+/// per file state of the write-behind buffer
+struct WriteBehindState {
+  WriteBehindState() : cond(0), writing(false), start(0), len(0), capacity(0), inflight(0),
+                       inflightEnd(0), error(0) {}
+  // protects all fields, signaled when a flush or a write completes
+  XrdSysCondVar cond;
+  // set while a write goes through the buffer. Writes of the file go
+  // through one at a time, so that they land in order even when the lock
+  // is released during one of them
+  bool writing;
+  // chunk being filled, holding [start, start+len[ of the file and ending
+  // at a chunk boundary once full
+  ceph::bufferptr buf;
+  uint64_t start;
+  uint64_t len;
+  uint64_t capacity;
+  // flushes in flight and highest file offset they cover
+  unsigned int inflight;
+  uint64_t inflightEnd;
+  // first error of a flush, reported by the next write, fsync or close
+  int error;
+};
+
+/// per file tracking of the async writes not yet completed
+struct AioWriteDrain {
+  AioWriteDrain() : cond(0), pending(0), error(0) {}
+  // protects pending and error, signaled when pending drops to 0
+  XrdSysCondVar cond;
+  unsigned int pending;
+  // first error of an async write, reported by the next fsync or close
+  int error;
+};
+
+/// checksums of a file computed while it is written. Data written in order
+/// extends the checksummed prefix, out of order pieces are kept aside with
+/// their own checksums and combined into the prefix once it reaches them
+struct StreamingChecksum {
+  StreamingChecksum() : valid(false), prefixEnd(0), adler(1), crc(0) {}
+  struct Segment {
+    uint64_t len;
+    uint32_t adler;
+    uint32_t crc;
+  };
+  XrdSysMutex mutex;
+  // false when not used or when a write made streaming impossible
+  bool valid;
+  uint64_t prefixEnd;
+  uint32_t adler;
+  uint32_t crc;
+  // out of order pieces, by offset, never overlapping nor adjacent
+  std::map<uint64_t, Segment> segments;
+};
+
+/// per file state of the coalescing of aio reads
+struct AioCoalesceState {
+  AioCoalesceState() : batch(0), end(0) {}
+  XrdSysMutex mutex;
+  // reads waiting for the end of the window to be submitted together
+  ObjectReadRequest *batch;
+  // end offset of the last read added to the batch
+  uint64_t end;
+};
+
 struct CephFileRef : CephFile {
   int flags;
   mode_t mode;
   uint64_t offset;
-  // This mutex protects against parallel updates of the stats.
-  XrdSysMutex statsMutex;
-  uint64_t maxOffsetWritten;
-  uint64_t bytesAsyncWritePending;
-  uint64_t bytesWritten;
-  unsigned rdcount;
-  unsigned wrcount;
-  unsigned asyncRdStartCount;
-  unsigned asyncRdCompletionCount;
-  unsigned asyncWrStartCount;
-  unsigned asyncWrCompletionCount;
-  ::timeval lastAsyncSubmission;
-  double longestAsyncWriteTime;
-  double longestCallbackInvocation;
+  // ceph handles resolved once at open time, so that the I/O paths
+  // do not go through the global dictionaries of stripers
+  librados::Rados *cluster;
+  librados::IoCtx *ioctx;
+  libradosstriper::RadosStriper *striper;
+  unsigned int cephPoolIdx;
+  XrdCephLayoutKey layoutKey;
+  // Size and modification time of the file as known locally. They are filled
+  // from the stat done at open (when statCached is set) and kept up to date by
+  // our own writes and truncates, so that fstat can be served locally
+  std::atomic<bool> statCached;
+  std::atomic<uint64_t> size;
+  std::atomic<time_t> mtime;
+  // Striping of the file over RADOS objects, as stored in the xattrs of its
+  // first object. Loaded on first use, protected by stripeLayoutMutex until
+  // stripeLayoutKnown is set
+  XrdSysMutex stripeLayoutMutex;
+  std::atomic<bool> stripeLayoutKnown;
+  XrdCephStripeLayout stripeLayout;
+  // whether reads go directly to the objects of the file, bypassing the
+  // striper. Only for files open for read whose layout and size were
+  // loaded at open
+  bool directReads;
+  ReadAheadState readAhead;
+  AioCoalesceState aioCoalesce;
+  OpenPrefetch prefetch;
+  WriteBehindState writeBehind;
+  AioWriteDrain aioWrites;
+  StreamingChecksum checksum;
+  XrdCephCommittedRanges committed;
+  // The stats are updated without locking, both by the xrootd threads and by
+  // the librados callbacks. Counters updated at submission and at completion
+  // of operations live on different cache lines.
+  // Write submission
+  alignas(64) std::atomic<unsigned> wrcount;
+  std::atomic<unsigned> asyncWrStartCount;
+  std::atomic<uint64_t> lastAsyncSubmission; // in microseconds since epoch
+  std::atomic<uint64_t> bytesAsyncWritePending;
+  // async writes admitted by the in flight limits and not yet completed,
+  // and time spent throttled, in microseconds
+  std::atomic<uint64_t> aioWriteInflightBytes;
+  std::atomic<unsigned> aioWriteInflightOps;
+  std::atomic<uint64_t> writeThrottleTime;
+  // Write completion
+  alignas(64) std::atomic<unsigned> asyncWrCompletionCount;
+  std::atomic<uint64_t> bytesWritten;
+  std::atomic<uint64_t> maxOffsetWritten;
+  std::atomic<double> longestAsyncWriteTime;
+  std::atomic<double> longestCallbackInvocation;
+  // Read submission
+  alignas(64) std::atomic<unsigned> rdcount;
+  std::atomic<unsigned> asyncRdStartCount;
+  // Read completion
+  alignas(64) std::atomic<unsigned> asyncRdCompletionCount;
+  std::atomic<uint64_t> bytesCopiedOnRead;
+  std::atomic<uint64_t> bytesReadAhead;
+  std::atomic<uint64_t> bytesFromReadAhead;
+  std::atomic<uint64_t> bytesReadAsHoles;
+  std::atomic<uint64_t> bytesFromPrefetch;
+
+  // allocation honoring the alignment of the stats
+  static void* operator new(size_t size) {
+    void *p;
+    if (posix_memalign(&p, 64, size)) throw std::bad_alloc();
+    return p;
+  }
+  static void operator delete(void *p) { free(p); }
 };
 
+/// monotonic update of an atomic maximum
+template <typename T>
+static inline void atomicMax(std::atomic<T> &a, T value) {
+  T current = a.load(std::memory_order_relaxed);
+  while (current < value &&
+         !a.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+}
+
+/// time since epoch in microseconds
+static inline uint64_t timevalToMicroseconds(const ::timeval &tv) {
+  return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
 /// small struct for directory listing
 struct DirIterator {
   librados::NObjectIterator m_iterator;
@@ -89,12 +281,16 @@ struct DirIterator {
 
 /// small struct for aio API callbacks
 struct AioArgs {
-  AioArgs(XrdSfsAio* a, AioCB *b, size_t n, int _fd, ceph::bufferlist *_bl=0) :
-    aiop(a), callback(b), nbBytes(n), fd(_fd), bl(_bl) { ::gettimeofday(&startTime, nullptr); }
+  AioArgs(XrdSfsAio* a, AioCB *b, size_t n, int _fd, unsigned int _cephPoolIdx,
+          ceph::bufferlist *_bl=0) :
+    aiop(a), callback(b), nbBytes(n), fd(_fd), cephPoolIdx(_cephPoolIdx), bl(_bl) {
+    ::gettimeofday(&startTime, nullptr);
+  }
   XrdSfsAio* aiop;
   AioCB *callback;
   size_t nbBytes;
   int fd;
+  unsigned int cephPoolIdx;
   ::timeval startTime;
   ceph::bufferlist *bl;
 };
@@ -102,15 +298,48 @@ struct AioArgs {
 /// global variables holding stripers/ioCtxs/cluster objects
 /// Note that we have a pool of them to circumvent the limitation
 /// of having a single objecter/messenger per IoCtx
-typedef std::map<std::string, libradosstriper::RadosStriper*> StriperDict;
-std::vector<StriperDict> g_radosStripers;
-typedef std::map<std::string, librados::IoCtx*> IOCtxDict;
-std::vector<IOCtxDict> g_ioCtx;
+/// Each pool entry has a table of IoCtx/striper per file layout, whose mutex
+/// serializes the creation of new entries and of the underlying cluster.
+/// Lookups of existing entries do not take any lock
+struct CephLayoutHandles {
+  librados::IoCtx *ioctx;
+  libradosstriper::RadosStriper *striper;
+};
+typedef XrdCephLayoutTable<CephLayoutHandles> LayoutDict;
+std::vector<LayoutDict*> g_layoutDicts;
 std::vector<librados::Rados*> g_cluster;
-/// mutex protecting the striper and ioctx maps
-XrdSysMutex g_striper_mutex;
-/// index of current Striper/IoCtx to be used
-unsigned int g_cephPoolIdx = 0;
+/// interned userIds and pools used in the layout keys
+XrdCephStringInterner g_layoutNames;
+/// load of each pool entry, i.e. operations and bytes in flight,
+/// used by the load aware selection policies. Also keeps totals
+/// so that the balance between entries can be checked.
+/// Entries are aligned on a cache line as they are updated by all I/Os
+struct alignas(64) CephPoolLoad {
+  CephPoolLoad() : inflightOps(0), inflightBytes(0), totalOps(0), totalBytes(0) {}
+  std::atomic<long long> inflightOps;
+  std::atomic<long long> inflightBytes;
+  std::atomic<unsigned long long> totalOps;
+  std::atomic<unsigned long long> totalBytes;
+};
+std::vector<CephPoolLoad*> g_cephPoolLoad;
+/// policies for selecting a pool entry for new operations
+enum CephPoolPolicy {
+  CephPoolRoundRobin,       // blind rotation over the entries
+  CephPoolLeastOutstanding, // entry with the least load
+  CephPoolPowerOfTwo        // least loaded of two random entries
+};
+CephPoolPolicy g_cephPoolPolicy = CephPoolRoundRobin;
+/// cost of an operation in the load of a pool entry, in addition to its bytes
+const long long g_cephPoolOpCost = 64 * 1024;
+/// interval in seconds between two reports of the pool entries loads, 0 means never
+unsigned int g_cephPoolReportInterval = 0;
+/// thread logging the loads every g_cephPoolReportInterval seconds, and its
+/// stop flag, protected by g_cephPoolReportCond
+std::thread *g_cephPoolReportThread = 0;
+XrdSysCondVar g_cephPoolReportCond(0);
+bool g_cephPoolReportStop = false;
+/// index of current Striper/IoCtx to be used in the round robin policy
+std::atomic<unsigned int> g_cephPoolIdx(0);
 /// size of the Striper/IoCtx pool, defaults to 1
 /// may be overwritten in the configuration file
 /// (See XrdCephOss::configure)
@@ -119,41 +348,380 @@ unsigned int g_maxCephPoolIdx = 1;
 /// populated in case of ceph.namelib entry in the config file in XrdCephOss
 XrdOucName2Name *g_namelib = 0;
 
+/// how fstat is served for files open for write. Files open for read
+/// always use the stat done at open time
+enum CephFstatMode {
+  CephFstatLocal,  // size and mtime tracked locally from our own writes
+  CephFstatCluster // refreshed from the cluster at each call
+};
+CephFstatMode g_fstatMode = CephFstatLocal;
+
+/// number of blocks the readahead engine keeps in flight ahead of sequential
+/// readers of files open for read. 0 disables readahead
+unsigned int g_readAheadWindow = 0;
+/// global memory budget of the readahead engine, in bytes
+unsigned long long g_readAheadBudget = 256 * 1024 * 1024;
+/// memory currently used by the readahead engine, in bytes
+std::atomic<unsigned long long> g_readAheadUsed(0);
+/// number of consecutive sequential reads triggering readahead
+const unsigned int g_readAheadTrigger = 2;
+
+/// whether files open for read are read directly from their objects rather
+/// than through the striper. Off by default, ceph.directreads on enables it
+bool g_directReads = false;
+
+/// librados flags of the direct object reads, selecting which replica serves
+/// them : the primary OSD (default), any replica, or the closest one
+int g_readFlags = librados::OPERATION_NOFLAG;
+/// whether direct object reads use sparse reads, transferring only the
+/// allocated extents of the objects, holes being zero filled locally
+bool g_sparseReads = false;
+/// whether write opens create new files themselves, with a single exclusive
+/// create of their first object, rather than stat-ing them first
+bool g_fastCreate = false;
+
+/// size of the chunks aggregated by the write-behind buffers of files
+/// open for write : off, a stripe unit or a whole object set
+enum WriteBehindChunk {WriteBehindOff, WriteBehindStripeUnit, WriteBehindObjectSet};
+WriteBehindChunk g_writeBehindChunk = WriteBehindOff;
+/// global memory cap of the write-behind buffers, in bytes, and what is
+/// currently reserved
+unsigned long long g_writeBehindCapacity = 256 * 1024 * 1024;
+std::atomic<unsigned long long> g_writeBehindUsed(0);
+/// what writes do when the cap is reached : go synchronously to the cluster,
+/// or wait a bit for memory to be freed by flushes before doing so
+enum WriteBehindOverflow {WriteBehindOverflowDirect, WriteBehindOverflowWait};
+WriteBehindOverflow g_writeBehindOverflow = WriteBehindOverflowDirect;
+/// signaled when write-behind memory is released
+XrdSysCondVar g_writeBehindMemCond(0);
+/// number of writes that found the write-behind cap reached
+std::atomic<unsigned long long> g_writeBehindOverflows(0);
+
+/// limits of the async writes in flight, per file and for the whole
+/// process, in bytes and in operations. 0 means unlimited
+unsigned long long g_aioWriteFileMaxBytes = 0;
+unsigned int g_aioWriteFileMaxOps = 0;
+unsigned long long g_aioWriteMaxBytes = 0;
+unsigned int g_aioWriteMaxOps = 0;
+/// whether any of these limits is set
+bool g_aioWriteLimited = false;
+/// what an async write exceeding the limits does : wait for writes in
+/// flight to complete, or be done synchronously
+enum AioWriteOverflow {AioWriteOverflowBlock, AioWriteOverflowSync};
+AioWriteOverflow g_aioWriteOverflow = AioWriteOverflowBlock;
+/// async writes in flight in the process
+std::atomic<unsigned long long> g_aioWriteInflightBytes(0);
+std::atomic<unsigned int> g_aioWriteInflightOps(0);
+/// signaled when an async write completes, if limits are set
+XrdSysCondVar g_aioWriteCond(0);
+/// number of throttled async writes, and time spent throttled, in microseconds
+std::atomic<unsigned long long> g_aioWriteThrottled(0);
+std::atomic<unsigned long long> g_aioWriteThrottleTime(0);
+
+/// maximal time fsync waits for the async writes of a file, in seconds.
+/// 0 waits for as long as needed
+unsigned int g_fsyncTimeout = 0;
+
+/// checksums computed while files are written, and stored at close
+bool g_streamAdler32 = false;
+bool g_streamCrc32c = false;
+/// maximal number of out of order pieces kept per file before giving up
+const size_t g_streamMaxSegments = 4096;
+
+/// rules of the open time prefetch : files whose name starts with prefix
+/// get their first head and last tail bytes read at open
+struct OpenPrefetchRule {
+  std::string prefix;
+  unsigned long long head;
+  unsigned long long tail;
+};
+std::vector<OpenPrefetchRule> g_openPrefetchRules;
+
+/// rules of the layout policy : new files whose name starts with prefix and
+/// whose size hint (oss.asize) lies in [minSize, maxSize] get the given
+/// layout, unless one was explicitly given in their path or environment
+struct LayoutRule {
+  std::string prefix;
+  bool anySize;
+  unsigned long long minSize;
+  unsigned long long maxSize;
+  unsigned int nbStripes;
+  unsigned long long stripeUnit;
+  unsigned long long objectSize;
+};
+std::vector<LayoutRule> g_layoutRules;
+
+/// deadline policy and watchdog of hedged object reads
+XrdCephHedger g_hedger;
+
+/// window in microseconds during which aio reads of a file are held to be
+/// coalesced with the following ones. 0 disables coalescing
+unsigned int g_aioCoalesceWindow = 0;
+/// maximal gap in bytes between two aio reads to be coalesced
+unsigned long long g_aioCoalesceGap = 0;
+/// maximal size of a batch of coalesced aio reads
+const unsigned long long g_aioCoalesceMaxBytes = 64 * 1024 * 1024;
+/// number of aio reads going through coalescing, and of batches submitted
+std::atomic<unsigned long long> g_aioCoalesceRequests(0);
+std::atomic<unsigned long long> g_aioCoalesceOps(0);
+/// queue of the (deadline, fd) of the batches to be submitted, its
+/// condition variable and the thread doing the submission
+std::deque<std::pair<std::chrono::steady_clock::time_point, int> > g_aioCoalesceQueue;
+XrdSysCondVar g_aioCoalesceCond(0);
+/// file whose batch the flusher is submitting, -1 if none. Close waits for
+/// it to be done before freeing the file
+int g_aioCoalesceFlushing = -1;
+std::thread *g_aioCoalesceThread = 0;
+bool g_aioCoalesceStop = false;
+
+/// process wide cache of the objects of files open for read, shared by
+/// all file descriptors. Disabled unless a capacity is configured
+XrdCephBlockCache<ceph::bufferlist> g_blockCache;
+/// blocks being fetched in the background for aio reads, so that each is
+/// only fetched once, and its mutex
+std::unordered_set<XrdCephBlockKey, XrdCephBlockKeyHash> g_blockCacheFills;
+XrdSysMutex g_blockCacheFillsMutex;
+
 /// global variable holding a list of files currently opened for write
 std::multiset<std::string> g_filesOpenForWrite;
-/// global variable holding a map of file descriptor to file reference
-std::map<unsigned int, CephFileRef> g_fds;
-/// global variable remembering the next available file descriptor
-unsigned int g_nextCephFd = 0;
-/// mutex protecting the map of file descriptors and the openForWrite multiset
+/// mutex protecting the openForWrite multiset
 XrdSysMutex g_fd_mutex;
+/// global table of file descriptors to file references
+XrdCephFdTable<CephFileRef> g_fds;
 /// mutex protecting initialization of ceph clusters
 XrdSysMutex g_init_mutex;
+/// whether the pool of Striper/IoCtx/cluster entries was allocated
+std::atomic<bool> g_cephPoolReady(false);
 
-/// Accessor to next ceph pool index
-/// Note that this is not thread safe, but we do not care
-/// as we only want a rough load balancing
-unsigned int getCephPoolIdxAndIncrease() {
-  if (g_radosStripers.size() == 0) {
+static void cephPoolReporter();
+
+/// allocates a pool load entry on its own cache line. Plain new does not
+/// honour the alignment of over-aligned types before C++17
+static CephPoolLoad* newCephPoolLoad() {
+  void *mem = 0;
+  if (posix_memalign(&mem, alignof(CephPoolLoad), sizeof(CephPoolLoad))) {
+    throw std::bad_alloc();
+  }
+  return new (mem) CephPoolLoad();
+}
+
+static void deleteCephPoolLoad(CephPoolLoad *load) {
+  load->~CephPoolLoad();
+  free(load);
+}
+
+/// allocates the pool of Striper/IoCtx/cluster entries if not yet done
+void initCephPool() {
+  if (!g_cephPoolReady.load(std::memory_order_acquire)) {
     // make sure we do not have a race condition here
     XrdSysMutexHelper lock(g_init_mutex);
     // double check now that we have the lock
-    if (g_radosStripers.size() == 0) {
+    if (!g_cephPoolReady.load(std::memory_order_relaxed)) {
       // initialization phase : allocate corresponding places in the vectors
       for (unsigned int i = 0; i < g_maxCephPoolIdx; i++) {
-        g_radosStripers.push_back(StriperDict());
-        g_ioCtx.push_back(IOCtxDict());
+        g_layoutDicts.push_back(new LayoutDict());
         g_cluster.push_back(0);
+        g_cephPoolLoad.push_back(newCephPoolLoad());
+      }
+      g_cephPoolReady.store(true, std::memory_order_release);
+      if (g_cephPoolReportInterval) {
+        g_cephPoolReportThread = new std::thread(cephPoolReporter);
       }
     }
   }
-  unsigned int res = g_cephPoolIdx;
-  unsigned nextValue = g_cephPoolIdx+1;
-  if (nextValue >= g_maxCephPoolIdx) {
-    nextValue = 0;
+}
+
+/// current load of a pool entry
+static inline long long getCephPoolLoad(unsigned int idx) {
+  return g_cephPoolLoad[idx]->inflightBytes.load(std::memory_order_relaxed) +
+    g_cephPoolLoad[idx]->inflightOps.load(std::memory_order_relaxed) * g_cephPoolOpCost;
+}
+
+/// cheap per thread pseudo random numbers for the power of two choices policy
+static inline unsigned int cephPoolRandom() {
+  static thread_local unsigned int state = 0;
+  if (0 == state) {
+    state = (unsigned int)std::hash<std::thread::id>()(std::this_thread::get_id()) | 1;
   }
-  g_cephPoolIdx = nextValue;
-  return res;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+/// Accessor to the ceph pool index to be used for a new operation,
+/// according to the configured policy
+unsigned int getCephPoolIdxAndIncrease() {
+  initCephPool();
+  unsigned int nbEntries = g_maxCephPoolIdx;
+  if (1 == nbEntries) return 0;
+  switch (g_cephPoolPolicy) {
+  case CephPoolLeastOutstanding: {
+    unsigned int best = g_cephPoolIdx.fetch_add(1, std::memory_order_relaxed) % nbEntries;
+    long long bestLoad = getCephPoolLoad(best);
+    for (unsigned int n = 1; n < nbEntries && bestLoad > 0; n++) {
+      unsigned int idx = (best + n) % nbEntries;
+      long long load = getCephPoolLoad(idx);
+      if (load < bestLoad) {
+        best = idx;
+        bestLoad = load;
+      }
+    }
+    return best;
+  }
+  case CephPoolPowerOfTwo: {
+    unsigned int r = cephPoolRandom();
+    unsigned int first = r % nbEntries;
+    unsigned int second = (first + 1 + (r >> 16) % (nbEntries - 1)) % nbEntries;
+    return getCephPoolLoad(second) < getCephPoolLoad(first) ? second : first;
+  }
+  default:
+    return g_cephPoolIdx.fetch_add(1, std::memory_order_relaxed) % nbEntries;
+  }
+}
+
+/// sets the policy for selecting pool entries. Returns -EINVAL for unknown policies
+int ceph_posix_set_pool_policy(const char *policy) {
+  if (!strcmp(policy, "roundrobin")) {
+    g_cephPoolPolicy = CephPoolRoundRobin;
+  } else if (!strcmp(policy, "leastoutstanding")) {
+    g_cephPoolPolicy = CephPoolLeastOutstanding;
+  } else if (!strcmp(policy, "poweroftwo")) {
+    g_cephPoolPolicy = CephPoolPowerOfTwo;
+  } else {
+    return -EINVAL;
+  }
+  return 0;
+}
+
+/// sets how fstat is served for files open for write. Returns -EINVAL for unknown modes
+int ceph_posix_set_fstat_mode(const char *mode) {
+  if (!strcmp(mode, "local")) {
+    g_fstatMode = CephFstatLocal;
+  } else if (!strcmp(mode, "cluster")) {
+    g_fstatMode = CephFstatCluster;
+  } else {
+    return -EINVAL;
+  }
+  return 0;
+}
+
+/// parses a size in KB into bytes. Only plain decimal numbers are accepted.
+/// Returns false in case of error
+static bool parseKB(const char *s, unsigned long long &bytes) {
+  std::string str(s);
+  if (str.empty() || std::string::npos != str.find_first_not_of("0123456789")) return false;
+  try {
+    unsigned long long value = std::stoull(str);
+    if (value > std::numeric_limits<unsigned long long>::max() / 1024) return false;
+    bytes = value * 1024;
+  } catch (std::exception &e) {
+    return false;
+  }
+  return true;
+}
+
+/// adds a rule of the open time prefetch, head and tail being sizes in KB,
+/// tail being optional. Not thread safe, to be called at configuration time.
+/// Returns -EINVAL if a size is invalid
+int ceph_posix_add_open_prefetch(const char *prefix, const char *head, const char *tail) {
+  OpenPrefetchRule rule = { prefix, 0, 0 };
+  if (!parseKB(head, rule.head) || (tail && !parseKB(tail, rule.tail))) return -EINVAL;
+  g_openPrefetchRules.push_back(rule);
+  return 0;
+}
+
+/// sets the limits of async writes in flight, 0 meaning unlimited.
+/// Returns -EINVAL for unknown overflow policies
+int ceph_posix_set_aio_write_limits(unsigned long long fileMaxBytes, unsigned int fileMaxOps,
+                                    unsigned long long maxBytes, unsigned int maxOps,
+                                    const char *overflow) {
+  if (0 == overflow || !strcmp(overflow, "block")) {
+    g_aioWriteOverflow = AioWriteOverflowBlock;
+  } else if (!strcmp(overflow, "sync")) {
+    g_aioWriteOverflow = AioWriteOverflowSync;
+  } else {
+    return -EINVAL;
+  }
+  g_aioWriteFileMaxBytes = fileMaxBytes;
+  g_aioWriteFileMaxOps = fileMaxOps;
+  g_aioWriteMaxBytes = maxBytes;
+  g_aioWriteMaxOps = maxOps;
+  g_aioWriteLimited = fileMaxBytes || fileMaxOps || maxBytes || maxOps;
+  return 0;
+}
+
+/// enables the streaming of a checksum while files are written. Returns
+/// -EINVAL for unsupported algorithms
+int ceph_posix_set_streaming_checksum(const char *algorithm) {
+  if (!strcmp(algorithm, "adler32")) {
+    g_streamAdler32 = true;
+  } else if (!strcmp(algorithm, "crc32c")) {
+    g_streamCrc32c = true;
+  } else {
+    return -EINVAL;
+  }
+  return 0;
+}
+
+/// configures write-behind. Returns -EINVAL for unknown chunk or overflow modes
+int ceph_posix_set_write_behind(const char *chunk, unsigned long long capacity,
+                                const char *overflow) {
+  if (!strcmp(chunk, "off")) {
+    g_writeBehindChunk = WriteBehindOff;
+  } else if (!strcmp(chunk, "stripeunit")) {
+    g_writeBehindChunk = WriteBehindStripeUnit;
+  } else if (!strcmp(chunk, "objectset")) {
+    g_writeBehindChunk = WriteBehindObjectSet;
+  } else {
+    return -EINVAL;
+  }
+  if (capacity) g_writeBehindCapacity = capacity;
+  if (0 == overflow || !strcmp(overflow, "direct")) {
+    g_writeBehindOverflow = WriteBehindOverflowDirect;
+  } else if (!strcmp(overflow, "wait")) {
+    g_writeBehindOverflow = WriteBehindOverflowWait;
+  } else {
+    return -EINVAL;
+  }
+  return 0;
+}
+
+/// sets which replica serves direct object reads. Returns -EINVAL for unknown modes
+int ceph_posix_set_read_mode(const char *mode) {
+  if (!strcmp(mode, "primary")) {
+    g_readFlags = librados::OPERATION_NOFLAG;
+  } else if (!strcmp(mode, "balance")) {
+    g_readFlags = librados::OPERATION_BALANCE_READS;
+  } else if (!strcmp(mode, "localize")) {
+    g_readFlags = librados::OPERATION_LOCALIZE_READS;
+  } else {
+    return -EINVAL;
+  }
+  return 0;
+}
+
+/// enables hedging of direct object reads not completed by the given
+/// percentile of the object read latencies, 0 disabling it
+void ceph_posix_set_hedged_reads(double percentile, unsigned long long minDelayUs,
+                                 unsigned long long maxDelayUs) {
+  g_hedger.configure(percentile, minDelayUs, maxDelayUs);
+}
+
+/// accounts for an operation starting on a pool entry
+static inline void cephPoolOpStart(unsigned int idx, size_t nbBytes) {
+  CephPoolLoad &load = *g_cephPoolLoad[idx];
+  load.inflightOps.fetch_add(1, std::memory_order_relaxed);
+  load.inflightBytes.fetch_add(nbBytes, std::memory_order_relaxed);
+  load.totalOps.fetch_add(1, std::memory_order_relaxed);
+  load.totalBytes.fetch_add(nbBytes, std::memory_order_relaxed);
+}
+
+/// accounts for an operation finishing on a pool entry
+static inline void cephPoolOpEnd(unsigned int idx, size_t nbBytes) {
+  CephPoolLoad &load = *g_cephPoolLoad[idx];
+  load.inflightOps.fetch_sub(1, std::memory_order_relaxed);
+  load.inflightBytes.fetch_sub(nbBytes, std::memory_order_relaxed);
 }
 
 /// check whether a file is open for write
@@ -163,44 +731,38 @@ bool isOpenForWrite(std::string& name) {
 }
 
 /// look for a FileRef from its file descriptor
+/// This does not take any lock. The structure here is not protected from deletion,
+/// but we trust xrootd to ensure close (which does the deletion) will not be called
+/// before all previous calls are complete (including the async ones).
 CephFileRef* getFileRef(int fd) {
-  XrdSysMutexHelper lock(g_fd_mutex);
-  std::map<unsigned int, CephFileRef>::iterator it = g_fds.find(fd);
-  if (it != g_fds.end()) {
-    // We will release the lock upon exiting this function.
-    // The structure here is not protected from deletion, but we trust xrootd to
-    // ensure close (which does the deletion) will not be called before all previous
-    // calls are complete (including the async ones).
-    return &(it->second);
-  } else {
-    return 0;
-  }
+  return g_fds.get(fd);
 }
 
 /// deletes a FileRef from the global table of file descriptors
 void deleteFileRef(int fd, const CephFileRef &fr) {
-  XrdSysMutexHelper lock(g_fd_mutex);
   if (fr.flags & (O_WRONLY|O_RDWR)) {
+    XrdSysMutexHelper lock(g_fd_mutex);
     g_filesOpenForWrite.erase(g_filesOpenForWrite.find(fr.name));
   }
-  std::map<unsigned int, CephFileRef>::iterator it = g_fds.find(fd);
-  if (it != g_fds.end()) {
-    g_fds.erase(it);
-  }
+  delete g_fds.remove(fd);
 }
 
 /**
  * inserts a new FileRef into the global table of file descriptors
- * and return the associated file descriptor
+ * and return the associated file descriptor, or -EMFILE if the table is full
+ * The table takes ownership of the FileRef, which is deleted on failure
  */
-int insertFileRef(CephFileRef &fr) {
-  XrdSysMutexHelper lock(g_fd_mutex);
-  g_fds[g_nextCephFd] = fr;
-  g_nextCephFd++;
-  if (fr.flags & (O_WRONLY|O_RDWR)) {
-    g_filesOpenForWrite.insert(fr.name);
+int insertFileRef(CephFileRef *fr) {
+  int fd = g_fds.insert(fr);
+  if (fd < 0) {
+    delete fr;
+    return fd;
+  }
+  if (fr->flags & (O_WRONLY|O_RDWR)) {
+    XrdSysMutexHelper lock(g_fd_mutex);
+    g_filesOpenForWrite.insert(fr->name);
   }
-  return g_nextCephFd-1;
+  return fd;
 }
 
 /// global variable containing defaults for CephFiles
@@ -303,9 +865,10 @@ static int fillCephPool(const std::string &params, unsigned int offset, XrdOucEn
 /// fills the nbStriped of a ceph file struct from a string and an environment
 /// returns position of first character after the nbStripes
 // this may raise std::invalid_argument and std::out_of_range
-static int fillCephNbStripes(const std::string &params, unsigned int offset, XrdOucEnv *env, CephFile &file) {
+static int fillCephNbStripes(const std::string &params, unsigned int offset, XrdOucEnv *env,
+                             const CephFile &defaults, CephFile &file) {
   // default
-  file.nbStripes = g_defaultParams.nbStripes;
+  file.nbStripes = defaults.nbStripes;
   // parsing
   size_t comPos = params.find(',', offset);
   if (std::string::npos == comPos) {
@@ -329,9 +892,10 @@ static int fillCephNbStripes(const std::string &params, unsigned int offset, Xrd
 /// fills the stripeUnit of a ceph file struct from a string and an environment
 /// returns position of first character after the stripeUnit
 // this may raise std::invalid_argument and std::out_of_range
-static int fillCephStripeUnit(const std::string &params, unsigned int offset, XrdOucEnv *env, CephFile &file) {
+static int fillCephStripeUnit(const std::string &params, unsigned int offset, XrdOucEnv *env,
+                              const CephFile &defaults, CephFile &file) {
   // default
-  file.stripeUnit = g_defaultParams.stripeUnit;
+  file.stripeUnit = defaults.stripeUnit;
   // parsing
   size_t comPos = params.find(',', offset);
   if (std::string::npos == comPos) {
@@ -355,9 +919,10 @@ static int fillCephStripeUnit(const std::string &params, unsigned int offset, Xr
 /// fills the objectSize of a ceph file struct from a string and an environment
 /// returns position of first character after the objectSize
 // this may raise std::invalid_argument and std::out_of_range
-static void fillCephObjectSize(const std::string &params, unsigned int offset, XrdOucEnv *env, CephFile &file) {
+static void fillCephObjectSize(const std::string &params, unsigned int offset, XrdOucEnv *env,
+                               const CephFile &defaults, CephFile &file) {
   // default
-  file.objectSize = g_defaultParams.objectSize;
+  file.objectSize = defaults.objectSize;
   // parsing
   if (params.size() == offset) {
     if (NULL != env) {
@@ -371,15 +936,22 @@ static void fillCephObjectSize(const std::string &params, unsigned int offset, X
   }
 }
 
-/// fill the parameters of a ceph file struct (all but name) from a string and an environment
-/// see fillCephFile for the detailed syntax
-void fillCephFileParams(const std::string &params, XrdOucEnv *env, CephFile &file) {
+/// fill the parameters of a ceph file struct (all but name) from a string and an environment,
+/// the layout defaulting to the one of defaults
+static void fillCephFileParams(const std::string &params, XrdOucEnv *env,
+                               const CephFile &defaults, CephFile &file) {
   // parse the params one by one
   unsigned int afterUser = fillCephUserId(params, env, file);
   unsigned int afterPool = fillCephPool(params, afterUser, env, file);
-  unsigned int afterNbStripes = fillCephNbStripes(params, afterPool, env, file);
-  unsigned int afterStripeUnit = fillCephStripeUnit(params, afterNbStripes, env, file);
-  fillCephObjectSize(params, afterStripeUnit, env, file);
+  unsigned int afterNbStripes = fillCephNbStripes(params, afterPool, env, defaults, file);
+  unsigned int afterStripeUnit = fillCephStripeUnit(params, afterNbStripes, env, defaults, file);
+  fillCephObjectSize(params, afterStripeUnit, env, defaults, file);
+}
+
+/// fill the parameters of a ceph file struct (all but name) from a string and an environment
+/// see fillCephFile for the detailed syntax
+void fillCephFileParams(const std::string &params, XrdOucEnv *env, CephFile &file) {
+  fillCephFileParams(params, env, g_defaultParams, file);
 }
 
 /// sets the default userId, pool and file layout
@@ -393,6 +965,85 @@ void ceph_posix_set_defaults(const char* value) {
   }
 }
 
+/// parses a size in bytes with an optional k, m or g (powers of 1024) suffix
+/// may throw std::invalid_argument or std::out_of_range in case of error
+static unsigned long long parseSize(std::string s) {
+  unsigned long long unit = 1;
+  if (!s.empty()) {
+    switch (tolower(s.back())) {
+    case 'k': unit = 1024ULL; break;
+    case 'm': unit = 1024ULL * 1024; break;
+    case 'g': unit = 1024ULL * 1024 * 1024; break;
+    }
+    if (unit > 1) s.pop_back();
+  }
+  unsigned long long value = ::stoull(s);
+  if (value > std::numeric_limits<unsigned long long>::max() / unit) {
+    throw std::out_of_range(s);
+  }
+  return value * unit;
+}
+
+/**
+ * adds a rule of the layout policy. Not thread safe, to be called at
+ * configuration time. sizes is either * for any file, including those
+ * without size hint, or [min]-[max] with inclusive bounds. layout is
+ * nbStripes,stripeUnit,objectSize, sizes in bytes with optional k, m or g
+ * suffix. Returns -EINVAL if any of them is invalid
+ */
+int ceph_posix_add_layout_rule(const char *prefix, const char *sizes, const char *layout) {
+  LayoutRule rule;
+  rule.prefix = prefix;
+  rule.anySize = !strcmp(sizes, "*");
+  rule.minSize = 0;
+  rule.maxSize = std::numeric_limits<unsigned long long>::max();
+  try {
+    if (!rule.anySize) {
+      std::string range(sizes);
+      size_t dashPos = range.find('-');
+      if (std::string::npos == dashPos) return -EINVAL;
+      if (dashPos > 0) rule.minSize = parseSize(range.substr(0, dashPos));
+      if (dashPos + 1 < range.size()) rule.maxSize = parseSize(range.substr(dashPos + 1));
+    }
+    std::string l(layout);
+    size_t comPos1 = l.find(',');
+    size_t comPos2 = std::string::npos == comPos1 ? comPos1 : l.find(',', comPos1 + 1);
+    if (std::string::npos == comPos2) return -EINVAL;
+    rule.nbStripes = stoui(l.substr(0, comPos1));
+    rule.stripeUnit = parseSize(l.substr(comPos1 + 1, comPos2 - comPos1 - 1));
+    rule.objectSize = parseSize(l.substr(comPos2 + 1));
+  } catch (std::exception &e) {
+    return -EINVAL;
+  }
+  // objects hold a whole number of stripe units
+  if (rule.minSize > rule.maxSize || 0 == rule.nbStripes || 0 == rule.stripeUnit ||
+      0 == rule.objectSize || rule.objectSize % rule.stripeUnit) {
+    return -EINVAL;
+  }
+  g_layoutRules.push_back(rule);
+  return 0;
+}
+
+/// layout policy rule applying to a new file, if any : the one with the
+/// longest matching prefix, the first one configured among equals
+static const LayoutRule* findLayoutRule(const std::string &name, XrdOucEnv *env) {
+  bool hasSize = false;
+  unsigned long long size = 0;
+  char *asize = env ? env->Get("oss.asize") : 0;
+  if (asize) {
+    char *end;
+    size = strtoull(asize, &end, 10);
+    hasSize = (*asize != '\0' && *end == '\0');
+  }
+  const LayoutRule *best = 0;
+  for (auto &rule : g_layoutRules) {
+    if (0 != name.compare(0, rule.prefix.size(), rule.prefix)) continue;
+    if (!rule.anySize && (!hasSize || size < rule.minSize || size > rule.maxSize)) continue;
+    if (0 == best || rule.prefix.size() > best->prefix.size()) best = &rule;
+  }
+  return best;
+}
+
 /// converts a logical filename to physical one if needed
 void translateFileName(std::string &physName, std::string logName){
   if (0 != g_namelib) {
@@ -411,8 +1062,9 @@ void translateFileName(std::string &physName, std::string logName){
   }
 }
 
-/// fill a ceph file struct from a path and an environment
-void fillCephFile(const char *path, XrdOucEnv *env, CephFile &file) {
+/// fill a ceph file struct from a path and an environment. For files about
+/// to be created, the layout policy replaces the default layout
+static void fillCephFile(const char *path, XrdOucEnv *env, bool creation, CephFile &file) {
   // Syntax of the given path is :
   //   [[userId@]pool[,nbStripes[,stripeUnit[,objectSize]]]:]<actual path>
   // for the missing parts, if env is not null the entries
@@ -425,14 +1077,27 @@ void fillCephFile(const char *path, XrdOucEnv *env, CephFile &file) {
   // If namelib is specified, apply translation to the whole path (which might include pool, etc)
   translateFileName(spath,path);
   size_t colonPos = spath.find(':');
+  std::string params;
   if (std::string::npos == colonPos) {
     // deal with name translation
     file.name = spath;
-    fillCephFileParams("", env, file);
   } else {
     file.name = spath.substr(colonPos+1);
-    fillCephFileParams(spath.substr(0, colonPos), env, file);
+    params = spath.substr(0, colonPos);
+  }
+  CephFile defaults = g_defaultParams;
+  const LayoutRule *rule = creation ? findLayoutRule(file.name, env) : 0;
+  if (rule) {
+    defaults.nbStripes = rule->nbStripes;
+    defaults.stripeUnit = rule->stripeUnit;
+    defaults.objectSize = rule->objectSize;
   }
+  fillCephFileParams(params, env, defaults, file);
+}
+
+/// fill a ceph file struct from a path and an environment
+void fillCephFile(const char *path, XrdOucEnv *env, CephFile &file) {
+  fillCephFile(path, env, false, file);
 }
 
 static CephFile getCephFile(const char *path, XrdOucEnv *env) {
@@ -441,29 +1106,49 @@ static CephFile getCephFile(const char *path, XrdOucEnv *env) {
   return file;
 }
 
-static CephFileRef getCephFileRef(const char *path, XrdOucEnv *env, int flags,
-                                  mode_t mode, unsigned long long offset) {
-  CephFileRef fr;
-  fillCephFile(path, env, fr);
-  fr.flags = flags;
-  fr.mode = mode;
-  fr.offset = 0;
-  fr.maxOffsetWritten = 0;
-  fr.bytesAsyncWritePending = 0;
-  fr.bytesWritten = 0;
-  fr.rdcount = 0;
-  fr.wrcount = 0;
-  fr.asyncRdStartCount = 0;
-  fr.asyncRdCompletionCount = 0;
-  fr.asyncWrStartCount = 0;
-  fr.asyncWrCompletionCount = 0;
-  fr.lastAsyncSubmission.tv_sec = 0;
-  fr.lastAsyncSubmission.tv_usec = 0;
-  fr.longestAsyncWriteTime = 0.0l;
-  fr.longestCallbackInvocation = 0.0l;
-  return fr;
+/// allocates a new file reference. The caller takes ownership
+static CephFileRef* getCephFileRef(const char *path, XrdOucEnv *env, int flags,
+                                   mode_t mode, unsigned long long offset) {
+  std::unique_ptr<CephFileRef> fr(new CephFileRef());
+  // only new files get a layout, written ones are always created
+  fillCephFile(path, env, (flags & O_ACCMODE) != O_RDONLY, *fr);
+  fr->flags = flags;
+  fr->mode = mode;
+  fr->offset = 0;
+  fr->cluster = 0;
+  fr->ioctx = 0;
+  fr->striper = 0;
+  fr->cephPoolIdx = 0;
+  fr->statCached = false;
+  fr->size = 0;
+  fr->mtime = 0;
+  fr->stripeLayoutKnown = false;
+  fr->directReads = false;
+  fr->maxOffsetWritten = 0;
+  fr->bytesAsyncWritePending = 0;
+  fr->aioWriteInflightBytes = 0;
+  fr->aioWriteInflightOps = 0;
+  fr->writeThrottleTime = 0;
+  fr->bytesWritten = 0;
+  fr->rdcount = 0;
+  fr->wrcount = 0;
+  fr->asyncRdStartCount = 0;
+  fr->asyncRdCompletionCount = 0;
+  fr->bytesCopiedOnRead = 0;
+  fr->bytesReadAhead = 0;
+  fr->bytesFromReadAhead = 0;
+  fr->bytesReadAsHoles = 0;
+  fr->bytesFromPrefetch = 0;
+  fr->asyncWrStartCount = 0;
+  fr->asyncWrCompletionCount = 0;
+  fr->lastAsyncSubmission = 0;
+  fr->longestAsyncWriteTime = 0.0l;
+  fr->longestCallbackInvocation = 0.0l;
+  return fr.release();
 }
 
+/// connects the cluster of the given pool entry if not yet done
+/// must be called with the mutex of the corresponding LayoutDict held
 inline librados::Rados* checkAndCreateCluster(unsigned int cephPoolIdx,
                                               std::string userId = g_defaultParams.userId) {
   if (0 == g_cluster[cephPoolIdx]) {
@@ -498,146 +1183,813 @@ inline librados::Rados* checkAndCreateCluster(unsigned int cephPoolIdx,
   return g_cluster[cephPoolIdx];
 }
 
-int checkAndCreateStriper(unsigned int cephPoolIdx, std::string &userAtPool, const CephFile& file) {
-  StriperDict &sDict = g_radosStripers[cephPoolIdx];
-  StriperDict::iterator it = sDict.find(userAtPool);
-  if (it == sDict.end()) {
-    // we need to create a new radosStriper
-    // Get a cluster
-    librados::Rados* cluster = checkAndCreateCluster(cephPoolIdx, file.userId);
-    if (0 == cluster) {
-      logwrapper((char*)"checkAndCreateStriper : checkAndCreateCluster failed");
-      return 0;
-    }
-    // create IoCtx for our pool
-    librados::IoCtx *ioctx = new librados::IoCtx;
-    if (0 == ioctx) {
-      logwrapper((char*)"checkAndCreateStriper : IoCtx instantiation failed");
-      cluster->shutdown();
-      delete cluster;
-      g_cluster[cephPoolIdx] = 0;
-      return 0;
-    }
-    int rc = g_cluster[cephPoolIdx]->ioctx_create(file.pool.c_str(), *ioctx);
-    if (rc != 0) {
-      logwrapper((char*)"checkAndCreateStriper : ioctx_create failed, rc = %d", rc);
-      cluster->shutdown();
-      delete cluster;
-      g_cluster[cephPoolIdx] = 0;
-      delete ioctx;
-      return 0;
-    }
-    // create RadosStriper connection
-    libradosstriper::RadosStriper *striper = new libradosstriper::RadosStriper;
-    if (0 == striper) {
-      logwrapper((char*)"checkAndCreateStriper : RadosStriper instantiation failed");
-      delete ioctx;
-      cluster->shutdown();
-      delete cluster;
-      g_cluster[cephPoolIdx] = 0;
-      return 0;
-    }
-    rc = libradosstriper::RadosStriper::striper_create(*ioctx, striper);
-    if (rc != 0) {
-      logwrapper((char*)"checkAndCreateStriper : striper_create failed, rc = %d", rc);
-      delete striper;
-      delete ioctx;
-      cluster->shutdown();
-      delete cluster;
-      g_cluster[cephPoolIdx] = 0;
-      return 0;
-    }
-    // setup layout
-    rc = striper->set_object_layout_stripe_count(file.nbStripes);
-    if (rc != 0) {
-      logwrapper((char*)"checkAndCreateStriper : invalid nbStripes %d", file.nbStripes);
-      delete striper;
-      delete ioctx;
-      cluster->shutdown();
-      delete cluster;
-      g_cluster[cephPoolIdx] = 0;
-      return 0;
-    }
-    rc = striper->set_object_layout_stripe_unit(file.stripeUnit);
-    if (rc != 0) {
-      logwrapper((char*)"checkAndCreateStriper : invalid stripeUnit %d (must be non 0, multiple of 64K)", file.stripeUnit);
-      delete striper;
-      delete ioctx;
-      cluster->shutdown();
-      delete cluster;
-      g_cluster[cephPoolIdx] = 0;
-      return 0;
-    }
-    rc = striper->set_object_layout_object_size(file.objectSize);
-    if (rc != 0) {
-      logwrapper((char*)"checkAndCreateStriper : invalid objectSize %d (must be non 0, multiple of stripe_unit)", file.objectSize);
-      delete striper;
-      delete ioctx;
-      cluster->shutdown();
-      delete cluster;
-      g_cluster[cephPoolIdx] = 0;
-      return 0;
-    }
-    IOCtxDict & ioDict = g_ioCtx[cephPoolIdx];
-    ioDict.insert(std::pair<std::string, librados::IoCtx*>(userAtPool, ioctx));
-    sDict.insert(std::pair<std::string, libradosstriper::RadosStriper*>
-                 (userAtPool, striper)).first;
+/// creates the IoCtx and striper for a given file layout in a given pool entry
+/// must be called with the mutex of the corresponding LayoutDict held
+static bool createStriper(unsigned int cephPoolIdx, const CephFile& file, CephLayoutHandles &handles) {
+  // Get a cluster
+  librados::Rados* cluster = checkAndCreateCluster(cephPoolIdx, file.userId);
+  if (0 == cluster) {
+    logwrapper((char*)"createStriper : checkAndCreateCluster failed");
+    return false;
   }
-  return 1;
-} 
+  // create IoCtx for our pool
+  librados::IoCtx *ioctx = new librados::IoCtx;
+  if (0 == ioctx) {
+    logwrapper((char*)"createStriper : IoCtx instantiation failed");
+    cluster->shutdown();
+    delete cluster;
+    g_cluster[cephPoolIdx] = 0;
+    return false;
+  }
+  int rc = g_cluster[cephPoolIdx]->ioctx_create(file.pool.c_str(), *ioctx);
+  if (rc != 0) {
+    logwrapper((char*)"createStriper : ioctx_create failed, rc = %d", rc);
+    cluster->shutdown();
+    delete cluster;
+    g_cluster[cephPoolIdx] = 0;
+    delete ioctx;
+    return false;
+  }
+  // create RadosStriper connection
+  libradosstriper::RadosStriper *striper = new libradosstriper::RadosStriper;
+  if (0 == striper) {
+    logwrapper((char*)"createStriper : RadosStriper instantiation failed");
+    delete ioctx;
+    cluster->shutdown();
+    delete cluster;
+    g_cluster[cephPoolIdx] = 0;
+    return false;
+  }
+  rc = libradosstriper::RadosStriper::striper_create(*ioctx, striper);
+  if (rc != 0) {
+    logwrapper((char*)"createStriper : striper_create failed, rc = %d", rc);
+    delete striper;
+    delete ioctx;
+    cluster->shutdown();
+    delete cluster;
+    g_cluster[cephPoolIdx] = 0;
+    return false;
+  }
+  // setup layout
+  rc = striper->set_object_layout_stripe_count(file.nbStripes);
+  if (rc != 0) {
+    logwrapper((char*)"createStriper : invalid nbStripes %d", file.nbStripes);
+    delete striper;
+    delete ioctx;
+    cluster->shutdown();
+    delete cluster;
+    g_cluster[cephPoolIdx] = 0;
+    return false;
+  }
+  rc = striper->set_object_layout_stripe_unit(file.stripeUnit);
+  if (rc != 0) {
+    logwrapper((char*)"createStriper : invalid stripeUnit %d (must be non 0, multiple of 64K)", file.stripeUnit);
+    delete striper;
+    delete ioctx;
+    cluster->shutdown();
+    delete cluster;
+    g_cluster[cephPoolIdx] = 0;
+    return false;
+  }
+  rc = striper->set_object_layout_object_size(file.objectSize);
+  if (rc != 0) {
+    logwrapper((char*)"createStriper : invalid objectSize %d (must be non 0, multiple of stripe_unit)", file.objectSize);
+    delete striper;
+    delete ioctx;
+    cluster->shutdown();
+    delete cluster;
+    g_cluster[cephPoolIdx] = 0;
+    return false;
+  }
+  handles.ioctx = ioctx;
+  handles.striper = striper;
+  return true;
+}
+
+/// finds the IoCtx and striper for a given file layout in a given pool entry,
+/// creating them if needed. Returns 0 in case of failure
+static CephLayoutHandles* getLayoutHandles(const CephFile& file, unsigned int cephPoolIdx,
+                                           XrdCephLayoutKey &key) {
+  if (!XrdCephLayoutKey::make(g_layoutNames, file.userId, file.pool, file.nbStripes,
+                              file.stripeUnit, file.objectSize, key)) {
+    logwrapper((char*)"getLayoutHandles : too many distinct users and pools");
+    return 0;
+  }
+  return g_layoutDicts[cephPoolIdx]->findOrCreate
+    (key, [&](CephLayoutHandles &handles) {
+      return createStriper(cephPoolIdx, file, handles);
+    });
+}
+
+static CephLayoutHandles* getLayoutHandles(const CephFile& file, unsigned int cephPoolIdx) {
+  XrdCephLayoutKey key;
+  return getLayoutHandles(file, cephPoolIdx, key);
+}
 
 static libradosstriper::RadosStriper* getRadosStriper(const CephFile& file) {
-  XrdSysMutexHelper lock(g_striper_mutex);
-  std::stringstream ss;
-  ss << file.userId << '@' << file.pool << ',' << file.nbStripes << ','
-     << file.stripeUnit << ',' << file.objectSize;
-  std::string userAtPool = ss.str();
   unsigned int cephPoolIdx = getCephPoolIdxAndIncrease();
-  if (checkAndCreateStriper(cephPoolIdx, userAtPool, file) == 0) {
-    logwrapper((char*)"getRadosStriper : checkAndCreateStriper failed");
+  CephLayoutHandles *handles = getLayoutHandles(file, cephPoolIdx);
+  if (0 == handles) {
+    logwrapper((char*)"getRadosStriper : createStriper failed");
     return 0;
   }
-  return g_radosStripers[cephPoolIdx][userAtPool];
+  return handles->striper;
 }
 
 static librados::IoCtx* getIoCtx(const CephFile& file) {
-  XrdSysMutexHelper lock(g_striper_mutex);
-  std::stringstream ss;
-  ss << file.userId << '@' << file.pool << ',' << file.nbStripes << ','
-     << file.stripeUnit << ',' << file.objectSize;
-  std::string userAtPool = ss.str();
   unsigned int cephPoolIdx = getCephPoolIdxAndIncrease();
-  if (checkAndCreateStriper(cephPoolIdx, userAtPool, file) == 0) {
+  CephLayoutHandles *handles = getLayoutHandles(file, cephPoolIdx);
+  if (0 == handles) {
+    return 0;
+  }
+  return handles->ioctx;
+}
+
+/// resolves the cluster, IoCtx and striper to be used for a file reference
+/// and caches them inside it. Returns 0 in case of failure
+static int bindCephHandles(CephFileRef &fr) {
+  unsigned int cephPoolIdx = getCephPoolIdxAndIncrease();
+  CephLayoutHandles *handles = getLayoutHandles(fr, cephPoolIdx, fr.layoutKey);
+  if (0 == handles) {
+    logwrapper((char*)"bindCephHandles : createStriper failed");
     return 0;
   }
-  return g_ioCtx[cephPoolIdx][userAtPool];
+  fr.cephPoolIdx = cephPoolIdx;
+  fr.cluster = g_cluster[cephPoolIdx];
+  fr.ioctx = handles->ioctx;
+  fr.striper = handles->striper;
+  return 1;
+}
+
+/// selects the pool entry to be used for a new I/O on an opened file, and
+/// returns the striper to be used. The lookup in the selected entry does not
+/// take any lock. If the file layout is not yet known there, no connection
+/// is attempted and the entry bound at open time is used
+static libradosstriper::RadosStriper* selectStriper(CephFileRef &fr, unsigned int &cephPoolIdx) {
+  cephPoolIdx = getCephPoolIdxAndIncrease();
+  if (cephPoolIdx != fr.cephPoolIdx) {
+    CephLayoutHandles *handles = g_layoutDicts[cephPoolIdx]->find(fr.layoutKey);
+    if (handles) return handles->striper;
+    cephPoolIdx = fr.cephPoolIdx;
+  }
+  return fr.striper;
+}
+
+/// cluster of the pool entry selected for an I/O, on which its completion
+/// is to be created
+static librados::Rados* selectedCluster(CephFileRef &fr, unsigned int cephPoolIdx) {
+  return cephPoolIdx == fr.cephPoolIdx ? fr.cluster : g_cluster[cephPoolIdx];
+}
+
+/// same as selectStriper for the IoCtx to be used for direct object I/O
+static librados::IoCtx* selectIoCtx(CephFileRef &fr, unsigned int &cephPoolIdx) {
+  cephPoolIdx = getCephPoolIdxAndIncrease();
+  if (cephPoolIdx != fr.cephPoolIdx) {
+    CephLayoutHandles *handles = g_layoutDicts[cephPoolIdx]->find(fr.layoutKey);
+    if (handles) return handles->ioctx;
+    cephPoolIdx = fr.cephPoolIdx;
+  }
+  return fr.ioctx;
+}
+
+/// logs the counters of the block cache
+static void reportBlockCache() {
+  if (!g_blockCache.enabled()) return;
+  logwrapper((char*)"ceph_block_cache : hits %llu, misses %llu, evictions %llu, "
+             "invalidations %llu, used bytes %llu",
+             g_blockCache.hits(), g_blockCache.misses(), g_blockCache.evictions(),
+             g_blockCache.invalidations(), g_blockCache.usedBytes());
+}
+
+/// logs the ratio of coalesced aio reads
+static void reportAioCoalesce() {
+  if (0 == g_aioCoalesceWindow) return;
+  unsigned long long requests = g_aioCoalesceRequests;
+  unsigned long long ops = g_aioCoalesceOps;
+  logwrapper((char*)"ceph_aio_coalesce : aio reads %llu, batches submitted %llu, merge ratio %f",
+             requests, ops, ops ? (double)requests / ops : 0.0);
+}
+
+/// logs the async writes in flight and the throttling they suffered
+static void reportAioWriteLimits() {
+  if (!g_aioWriteLimited) return;
+  logwrapper((char*)"ceph_aio_write_limits : in flight ops %u, in flight bytes %llu, "
+             "throttled writes %llu, throttle time %f s",
+             g_aioWriteInflightOps.load(), g_aioWriteInflightBytes.load(),
+             g_aioWriteThrottled.load(), 0.000001 * g_aioWriteThrottleTime.load());
+}
+
+/// logs the usage of the write-behind buffers
+static void reportWriteBehind() {
+  if (WriteBehindOff == g_writeBehindChunk) return;
+  logwrapper((char*)"ceph_write_behind : used bytes %llu/%llu, overflows %llu",
+             g_writeBehindUsed.load(), g_writeBehindCapacity, g_writeBehindOverflows.load());
+}
+
+/// logs the counters of hedged reads
+static void reportHedgedReads() {
+  if (!g_hedger.enabled()) return;
+  logwrapper((char*)"ceph_hedged_reads : current delay %llu us, hedges issued %llu, hedges won %llu",
+             (unsigned long long)g_hedger.delay(), g_hedger.issued(), g_hedger.wins());
+}
+
+/// sets the capacity of the block cache in bytes, 0 disabling it
+void ceph_posix_set_block_cache(unsigned long long capacity) {
+  g_blockCache.setCapacity(capacity);
+}
+
+/// logs the load of all pool entries
+void ceph_posix_report_pool_load() {
+  if (!g_cephPoolReady.load(std::memory_order_acquire)) return;
+  for (unsigned int i = 0; i < g_cephPoolLoad.size(); i++) {
+    CephPoolLoad &load = *g_cephPoolLoad[i];
+    logwrapper((char*)"ceph_pool_load : entry %d, in flight ops %lld, in flight bytes %lld, "
+               "total ops %llu, total bytes %llu", i,
+               load.inflightOps.load(), load.inflightBytes.load(),
+               load.totalOps.load(), load.totalBytes.load());
+  }
+}
+
+/// body of the thread logging the load of all pool entries, and the other
+/// counters, every g_cephPoolReportInterval seconds
+static void cephPoolReporter() {
+  g_cephPoolReportCond.Lock();
+  while (!g_cephPoolReportStop) {
+    // a timeout means the interval elapsed, otherwise we are stopping
+    if (!g_cephPoolReportCond.Wait(g_cephPoolReportInterval)) continue;
+    g_cephPoolReportCond.UnLock();
+    ceph_posix_report_pool_load();
+    reportBlockCache();
+    reportAioCoalesce();
+    reportHedgedReads();
+    reportWriteBehind();
+    reportAioWriteLimits();
+    g_cephPoolReportCond.Lock();
+  }
+  g_cephPoolReportCond.UnLock();
+}
+
+/// stops the thread reporting the loads, if any
+static void stopCephPoolReporter() {
+  g_cephPoolReportCond.Lock();
+  std::thread *reporter = g_cephPoolReportThread;
+  g_cephPoolReportThread = 0;
+  g_cephPoolReportStop = true;
+  g_cephPoolReportCond.Signal();
+  g_cephPoolReportCond.UnLock();
+  if (reporter) {
+    reporter->join();
+    delete reporter;
+  }
+  g_cephPoolReportStop = false;
+}
+
+/// connects all entries of the pool concurrently and creates in each of them
+/// the IoCtx and striper of the given layouts
+/// syntax of the layouts is [user@]pool[,nbStripes[,stripeUnit[,objectSize]]]
+/// may throw std::invalid_argument or std::out_of_range in case of syntax error
+int ceph_posix_warmup(const std::vector<std::string> &layouts) {
+  std::vector<CephFile> files;
+  for (unsigned int i = 0; i < layouts.size(); i++) {
+    CephFile file;
+    fillCephFileParams(layouts[i], NULL, file);
+    files.push_back(file);
+  }
+  initCephPool();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::atomic<int> nbFailures(0);
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < g_layoutDicts.size(); i++) {
+    threads.push_back(std::thread([i, &files, &nbFailures]() {
+      librados::Rados *cluster;
+      {
+        XrdSysMutexHelper lock(g_layoutDicts[i]->mutex());
+        cluster = checkAndCreateCluster(i);
+      }
+      bool ok = (0 != cluster);
+      for (unsigned int j = 0; ok && j < files.size(); j++) {
+        ok = (0 != getLayoutHandles(files[j], i));
+      }
+      if (!ok) nbFailures++;
+    }));
+  }
+  for (unsigned int i = 0; i < threads.size(); i++) {
+    threads[i].join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  logwrapper((char*)"ceph_warmup : %d connections, %d layouts, %d failures, took %f s",
+             (int)threads.size(), (int)files.size(), (int)nbFailures, elapsed.count());
+  return nbFailures;
 }
 
+static void stopAioCoalesce();
+static void unscheduleAioCoalesce(int fd);
+
 void ceph_posix_disconnect_all() {
-  XrdSysMutexHelper lock(g_striper_mutex);
-  for (unsigned int i= 0; i < g_maxCephPoolIdx; i++) {
-    for (StriperDict::iterator it2 = g_radosStripers[i].begin();
-         it2 != g_radosStripers[i].end();
-         it2++) {
-      delete it2->second;
-    }
-    for (IOCtxDict::iterator it2 = g_ioCtx[i].begin();
-         it2 != g_ioCtx[i].end();
-         it2++) {
-      delete it2->second;
-    }
+  stopCephPoolReporter();
+  stopAioCoalesce();
+  g_hedger.stop();
+  ceph_posix_report_pool_load();
+  reportBlockCache();
+  reportAioCoalesce();
+  reportHedgedReads();
+  reportWriteBehind();
+  reportAioWriteLimits();
+  for (unsigned int i= 0; i < g_layoutDicts.size(); i++) {
+    XrdSysMutexHelper lock(g_layoutDicts[i]->mutex());
+    g_layoutDicts[i]->forEach([](CephLayoutHandles &handles) {
+        delete handles.striper;
+        delete handles.ioctx;
+      });
+    g_layoutDicts[i]->clear();
     delete g_cluster[i];
   }
-  g_radosStripers.clear();
-  g_ioCtx.clear();
+  for (unsigned int i= 0; i < g_layoutDicts.size(); i++) {
+    delete g_layoutDicts[i];
+    deleteCephPoolLoad(g_cephPoolLoad[i]);
+  }
+  g_layoutDicts.clear();
   g_cluster.clear();
+  g_cephPoolLoad.clear();
+  g_cephPoolReady = false;
 }
 
 void ceph_posix_set_logfunc(void (*logfunc) (char *, va_list argp)) {
   g_logfunc = logfunc;
 };
 
+/// parses an unsigned integer stored in a striper xattr
+static bool parseStriperAttr(ceph::bufferlist &bl, uint64_t &value) {
+  std::string s(bl.c_str(), bl.length());
+  char *end;
+  value = strtoull(s.c_str(), &end, 10);
+  return !s.empty() && *end == '\0';
+}
+
+/// decodes the layout xattrs of the first object of a file
+static bool decodeStripeLayout(ceph::bufferlist &suBl, ceph::bufferlist &scBl,
+                               ceph::bufferlist &osBl, XrdCephStripeLayout &layout) {
+  return parseStriperAttr(suBl, layout.stripeUnit) &&
+    parseStriperAttr(scBl, layout.stripeCount) &&
+    parseStriperAttr(osBl, layout.objectSize) &&
+    layout.valid();
+}
+
+/**
+ * gets the striping of the file, as stored by libradosstriper in the
+ * xattrs of its first object. The result is cached in the file reference
+ * Returns 0 on success, a negative errno otherwise
+ */
+static int getStripeLayout(CephFileRef &fr, XrdCephStripeLayout &layout) {
+  if (!fr.stripeLayoutKnown.load(std::memory_order_acquire)) {
+    XrdSysMutexHelper lock(fr.stripeLayoutMutex);
+    if (!fr.stripeLayoutKnown.load(std::memory_order_relaxed)) {
+      ceph::bufferlist suBl, scBl, osBl;
+      int suRc, scRc, osRc;
+      librados::ObjectReadOperation op;
+      op.getxattr("striper.layout.stripe_unit", &suBl, &suRc);
+      op.getxattr("striper.layout.stripe_count", &scBl, &scRc);
+      op.getxattr("striper.layout.object_size", &osBl, &osRc);
+      int rc = fr.ioctx->operate(XrdCephStripeLayout::objectName(fr.name, 0), &op, 0);
+      if (rc < 0) return rc;
+      if (suRc < 0) return suRc;
+      if (scRc < 0) return scRc;
+      if (osRc < 0) return osRc;
+      XrdCephStripeLayout l;
+      if (!decodeStripeLayout(suBl, scBl, osBl, l)) {
+        logwrapper((char*)"getStripeLayout : invalid layout xattrs for %s", fr.name.c_str());
+        return -EINVAL;
+      }
+      fr.stripeLayout = l;
+      fr.stripeLayoutKnown.store(true, std::memory_order_release);
+    }
+  }
+  layout = fr.stripeLayout;
+  return 0;
+}
+
+/**
+ * loads in a single round trip the layout, size and mtime of a file from
+ * the xattrs and stat of its first object, where libradosstriper keeps them,
+ * without going through the striper and its lock. On success, reads of the
+ * file can be sent directly to its objects.
+ * Returns 0 on success, -ENOENT if the file does not exist, another
+ * negative errno if it could not be loaded this way
+ */
+static int loadObjectStat(CephFileRef &fr, uint64_t head) {
+  ceph::bufferlist suBl, scBl, osBl, sizeBl, headBl;
+  int suRc, scRc, osRc, sizeRc, statRc, headRc = 0;
+  uint64_t objectSize;
+  time_t mtime;
+  librados::ObjectReadOperation op;
+  op.getxattr("striper.layout.stripe_unit", &suBl, &suRc);
+  op.getxattr("striper.layout.stripe_count", &scBl, &scRc);
+  op.getxattr("striper.layout.object_size", &osBl, &osRc);
+  op.getxattr("striper.size", &sizeBl, &sizeRc);
+  op.stat(&objectSize, &mtime, &statRc);
+  // the head of the file comes in the same round trip
+  if (head) op.read(0, head, &headBl, &headRc);
+  int rc = fr.ioctx->operate(XrdCephStripeLayout::objectName(fr.name, 0), &op, 0);
+  if (rc < 0) return rc;
+  XrdCephStripeLayout layout;
+  uint64_t size;
+  if (!decodeStripeLayout(suBl, scBl, osBl, layout) || !parseStriperAttr(sizeBl, size)) {
+    return -EINVAL;
+  }
+  {
+    XrdSysMutexHelper lock(fr.stripeLayoutMutex);
+    fr.stripeLayout = layout;
+    fr.stripeLayoutKnown.store(true, std::memory_order_release);
+  }
+  fr.size = size;
+  fr.mtime = mtime;
+  fr.statCached = true;
+  if (head && headRc >= 0) {
+    // only the first stripe unit of object 0 is contiguous in the file,
+    // unless there is a single stripe
+    uint64_t usable = std::min(std::min(head, size), layout.stripeCount > 1 ?
+                               layout.stripeUnit : layout.objectSize);
+    if (headBl.length() >= usable) {
+      fr.prefetch.head.substr_of(headBl, 0, usable);
+    }
+  }
+  return 0;
+}
+
+/**
+ * creates a new file in a single round trip, as libradosstriper would on
+ * its first write : an exclusive create of the first object carrying the
+ * layout xattrs and a null size. The striper then finds and uses it.
+ * Returns 0 on success, -EEXIST if the file exists, another negative
+ * errno on failure
+ */
+static int createStripedFile(CephFileRef &fr) {
+  ceph::bufferlist suBl, scBl, osBl, sizeBl;
+  suBl.append(std::to_string(fr.stripeUnit));
+  scBl.append(std::to_string(fr.nbStripes));
+  osBl.append(std::to_string(fr.objectSize));
+  sizeBl.append(std::string("0"));
+  librados::ObjectWriteOperation op;
+  op.create(true);
+  op.setxattr("striper.layout.stripe_unit", suBl);
+  op.setxattr("striper.layout.stripe_count", scBl);
+  op.setxattr("striper.layout.object_size", osBl);
+  op.setxattr("striper.size", sizeBl);
+  int rc = fr.ioctx->operate(XrdCephStripeLayout::objectName(fr.name, 0), &op);
+  if (0 == rc) {
+    XrdSysMutexHelper lock(fr.stripeLayoutMutex);
+    fr.stripeLayout.stripeUnit = fr.stripeUnit;
+    fr.stripeLayout.stripeCount = fr.nbStripes;
+    fr.stripeLayout.objectSize = fr.objectSize;
+    fr.stripeLayoutKnown.store(true, std::memory_order_release);
+  }
+  return rc;
+}
+
+/// rule of the open time prefetch applying to a file, if any
+static const OpenPrefetchRule* findOpenPrefetchRule(const std::string &name) {
+  const OpenPrefetchRule *best = 0;
+  for (auto &rule : g_openPrefetchRules) {
+    if (0 == name.compare(0, rule.prefix.size(), rule.prefix) &&
+        (0 == best || rule.prefix.size() > best->prefix.size())) {
+      best = &rule;
+    }
+  }
+  return best;
+}
+
+static void startTailPrefetch(CephFileRef &fr, uint64_t tail);
+static void dropOpenPrefetch(CephFileRef &fr);
+
+ReadAheadBlock::~ReadAheadBlock() {
+  if (completion) completion->release();
+  g_readAheadUsed.fetch_sub(len, std::memory_order_relaxed);
+}
+
+/// drops a reference to a readahead block, deleting it if it was the last one
+static void unrefReadAheadBlock(ReadAheadBlock *block) {
+  if (1 == block->refs.fetch_sub(1, std::memory_order_acq_rel)) delete block;
+}
+
+static void ceph_readahead_complete(rados_completion_t c, void *arg) {
+  ReadAheadBlock *block = reinterpret_cast<ReadAheadBlock*>(arg);
+  cephPoolOpEnd(block->cephPoolIdx, block->len);
+  unrefReadAheadBlock(block);
+}
+
+/// empties the readahead window of a file. Blocks still in flight are
+/// deleted by their completion
+static void dropReadAhead(CephFileRef &fr) {
+  XrdSysMutexHelper lock(fr.readAhead.mutex);
+  for (auto block : fr.readAhead.window) unrefReadAheadBlock(block);
+  fr.readAhead.window.clear();
+}
+
+/// starts the prefetching of the block at the given offset within the global
+/// budget. Returns 0 if not possible. Has to be called with the readahead mutex
+static ReadAheadBlock* submitReadAhead(CephFileRef &fr, uint64_t offset, uint64_t len) {
+  if (g_readAheadUsed.fetch_add(len, std::memory_order_relaxed) + len > g_readAheadBudget) {
+    g_readAheadUsed.fetch_sub(len, std::memory_order_relaxed);
+    return 0;
+  }
+  unsigned int cephPoolIdx;
+  libradosstriper::RadosStriper *striper = selectStriper(fr, cephPoolIdx);
+  ReadAheadBlock *block = new ReadAheadBlock(offset, len, cephPoolIdx);
+  block->completion = selectedCluster(fr, cephPoolIdx)->aio_create_completion(block, ceph_readahead_complete, NULL);
+  // one reference for the window, one for the completion
+  block->refs = 2;
+  cephPoolOpStart(cephPoolIdx, len);
+  int rc = striper->aio_read(fr.name, block->completion, &block->bl, len, offset);
+  if (rc < 0) {
+    cephPoolOpEnd(cephPoolIdx, len);
+    delete block;
+    return 0;
+  }
+  fr.bytesReadAhead += len;
+  return block;
+}
+
+/**
+ * Tries to serve a read from the readahead window of the file. This also
+ * drives the engine : sequential reads slide the window forward and keep
+ * it full, any other read collapses it. Blocks still in flight are waited
+ * for, unless wait is false, as for aio reads that must not block the
+ * calling thread, in which case the read goes to the cluster.
+ * Returns false if the read has to be sent to the cluster, in which case
+ * rc is not set. Otherwise rc is the number of bytes read or a negative errno
+ */
+static bool readAheadRead(CephFileRef &fr, char *buf, size_t count, uint64_t offset,
+                          bool wait, ssize_t &rc) {
+  if (0 == g_readAheadWindow || 0 == count ||
+      (fr.flags & O_ACCMODE) != O_RDONLY || !fr.statCached) return false;
+  ReadAheadState &st = fr.readAhead;
+  uint64_t fileSize = fr.size;
+  if (offset >= fileSize) return false;
+  uint64_t end = std::min(offset + count, fileSize);
+  std::vector<ReadAheadBlock*> blocks;
+  {
+    XrdSysMutexHelper lock(st.mutex);
+    if (offset == st.nextOffset) {
+      st.seqCount++;
+    } else {
+      st.seqCount = 0;
+      for (auto block : st.window) unrefReadAheadBlock(block);
+      st.window.clear();
+    }
+    st.nextOffset = offset + count;
+    if (st.seqCount < g_readAheadTrigger) return false;
+    if (0 == st.blockSize) {
+      // prefetch whole objects, that is one full object set. The layout
+      // comes from open, it is not fetched here not to stall the reads
+      if (fr.stripeLayoutKnown.load(std::memory_order_acquire)) {
+        st.blockSize = fr.stripeLayout.objectSize * fr.stripeLayout.stripeCount;
+      } else {
+        st.blockSize = ~0ull;
+      }
+    }
+    if (~0ull == st.blockSize) return false;
+    // drop the blocks already consumed
+    while (!st.window.empty() &&
+           st.window.front()->offset + st.window.front()->len <= offset) {
+      unrefReadAheadBlock(st.window.front());
+      st.window.pop_front();
+    }
+    // refill the window
+    uint64_t next = st.window.empty() ? offset - offset % st.blockSize :
+      st.window.back()->offset + st.window.back()->len;
+    while (st.window.size() < g_readAheadWindow && next < fileSize) {
+      ReadAheadBlock *block = submitReadAhead(fr, next, std::min(st.blockSize, fileSize - next));
+      if (0 == block) break;
+      st.window.push_back(block);
+      next += block->len;
+    }
+    // check that the window covers the read
+    if (st.window.empty() || st.window.front()->offset > offset ||
+        st.window.back()->offset + st.window.back()->len < end) return false;
+    for (auto block : st.window) {
+      if (block->offset >= end) break;
+      if (!wait && !block->completion->is_complete()) {
+        for (auto b : blocks) unrefReadAheadBlock(b);
+        return false;
+      }
+      block->refs++;
+      blocks.push_back(block);
+    }
+  }
+  // wait for the data and copy it out, without holding the lock
+  rc = 0;
+  for (auto block : blocks) {
+    block->completion->wait_for_complete();
+    int brc = block->completion->get_return_value();
+    if (brc < 0) {
+      rc = brc;
+    } else if (rc >= 0) {
+      uint64_t from = std::max(offset, block->offset);
+      uint64_t to = std::min(end, block->offset + brc);
+      if (to > from) {
+        block->bl.copy(from - block->offset, to - from, buf + (from - offset));
+        rc += to - from;
+      }
+    }
+    unrefReadAheadBlock(block);
+  }
+  if (rc < 0) {
+    // let the regular path retry and report the error if any
+    dropReadAhead(fr);
+    return false;
+  }
+  fr.bytesFromReadAhead += rc;
+  return true;
+}
+
+/// identifier of a file in the block cache
+static std::string blockCacheFileId(const CephFile &file) {
+  std::string id(file.pool);
+  id.push_back('\0');
+  id += file.name;
+  return id;
+}
+
+/// makes the cached blocks of a file unreachable after it was modified locally
+static void invalidateBlockCache(const CephFile &file) {
+  if (g_blockCache.enabled()) g_blockCache.invalidate(blockCacheFileId(file));
+}
+
+/// generation of the blocks of a file open for read. Besides local
+/// invalidations, it changes with the size and mtime found at open, so that
+/// files rewritten by other servers are not served from stale blocks
+static uint64_t blockCacheGeneration(CephFileRef &fr) {
+  uint64_t gen = g_blockCache.generation(blockCacheFileId(fr));
+  return XrdCephLayoutKey::mix(gen ^ XrdCephLayoutKey::mix(fr.size ^ ((uint64_t)fr.mtime << 32)));
+}
+
+/// copies a piece of a cached object, zero filling what is beyond its end
+static void copyFromBlock(const ceph::bufferlist &bl, uint64_t objectOffset, char *buf, uint64_t len) {
+  uint64_t avail = bl.length() > objectOffset ? bl.length() - objectOffset : 0;
+  uint64_t n = std::min(avail, len);
+  if (n) bl.copy(objectOffset, n, buf);
+  if (n < len) memset(buf + n, 0, len - n);
+}
+
+/// small struct for the completion of the background fetch of a block
+struct BlockCacheFill {
+  XrdCephBlockKey key;
+  ceph::bufferlist bl;
+  unsigned int cephPoolIdx;
+  uint64_t len;
+};
+
+static void ceph_block_cache_fill_complete(rados_completion_t c, void *arg) {
+  BlockCacheFill *fill = reinterpret_cast<BlockCacheFill*>(arg);
+  int rc = rados_aio_get_return_value(c);
+  cephPoolOpEnd(fill->cephPoolIdx, fill->len);
+  if (rc >= 0 || -ENOENT == rc) {
+    // a missing object is a hole, cached as empty
+    std::shared_ptr<ceph::bufferlist> block = std::make_shared<ceph::bufferlist>();
+    if (rc >= 0) block->claim_append(fill->bl);
+    g_blockCache.put(fill->key, block, block->length());
+  }
+  {
+    XrdSysMutexHelper lock(g_blockCacheFillsMutex);
+    g_blockCacheFills.erase(fill->key);
+  }
+  delete fill;
+}
+
+/// fetches a whole object of a file into the block cache in the background,
+/// unless it is already being fetched
+static void startBlockCacheFill(CephFileRef &fr, const XrdCephBlockKey &key, uint64_t objectSize) {
+  {
+    XrdSysMutexHelper lock(g_blockCacheFillsMutex);
+    if (!g_blockCacheFills.insert(key).second) return;
+  }
+  BlockCacheFill *fill = new BlockCacheFill{key, ceph::bufferlist(), 0, objectSize};
+  librados::IoCtx *ioctx = selectIoCtx(fr, fill->cephPoolIdx);
+  librados::AioCompletion *completion =
+    selectedCluster(fr, fill->cephPoolIdx)->aio_create_completion(fill, ceph_block_cache_fill_complete, NULL);
+  cephPoolOpStart(fill->cephPoolIdx, objectSize);
+  int rc = ioctx->aio_read(XrdCephStripeLayout::objectName(fr.name, key.objectNo),
+                           completion, &fill->bl, objectSize, 0);
+  completion->release();
+  if (rc < 0) {
+    cephPoolOpEnd(fill->cephPoolIdx, objectSize);
+    XrdSysMutexHelper lock(g_blockCacheFillsMutex);
+    g_blockCacheFills.erase(key);
+    delete fill;
+  }
+}
+
+/**
+ * Tries to serve a read of a file open for read from the block cache.
+ * When fetch is set, the missing objects are fetched as a whole and in
+ * parallel to populate it, and waited for. Otherwise, as for aio reads,
+ * only reads fully cached are served, and the missing objects are fetched
+ * in the background for the next reads, without waiting.
+ * Returns false if the read has to be sent to the cluster, in which case
+ * rc is not set. Otherwise rc is the number of bytes read
+ */
+static bool blockCacheRead(CephFileRef &fr, char *buf, size_t count, uint64_t offset,
+                           bool fetch, ssize_t &rc) {
+  if (!g_blockCache.enabled() || 0 == count ||
+      (fr.flags & O_ACCMODE) != O_RDONLY || !fr.statCached) return false;
+  XrdCephStripeLayout layout;
+  if (fetch) {
+    if (getStripeLayout(fr, layout) < 0) return false;
+  } else if (fr.stripeLayoutKnown.load(std::memory_order_acquire)) {
+    // the layout is not fetched here not to stall aio reads
+    layout = fr.stripeLayout;
+  } else {
+    return false;
+  }
+  uint64_t fileSize = fr.size;
+  if (offset >= fileSize) {
+    rc = 0;
+    return true;
+  }
+  uint64_t end = std::min(offset + count, fileSize);
+  // find the objects involved and the cached ones
+  struct Piece { uint64_t objectNo; uint64_t objectOffset; char *buf; uint64_t len; };
+  std::vector<Piece> pieces;
+  layout.map(offset, end - offset,
+             [&](uint64_t objectNo, uint64_t objectOffset, uint64_t fileOffset, uint64_t len) {
+               Piece p = { objectNo, objectOffset, buf + (fileOffset - offset), len };
+               pieces.push_back(p);
+             });
+  XrdCephBlockKey key = { fr.pool, fr.name, 0, blockCacheGeneration(fr) };
+  std::map<uint64_t, std::shared_ptr<const ceph::bufferlist> > blocks;
+  std::map<uint64_t, std::pair<librados::AioCompletion*, std::shared_ptr<ceph::bufferlist> > > misses;
+  for (auto &p : pieces) {
+    if (blocks.count(p.objectNo) || misses.count(p.objectNo)) continue;
+    key.objectNo = p.objectNo;
+    std::shared_ptr<const ceph::bufferlist> block = g_blockCache.get(key);
+    if (block) {
+      blocks[p.objectNo] = block;
+    } else {
+      misses[p.objectNo] = std::make_pair((librados::AioCompletion*)0,
+                                          std::make_shared<ceph::bufferlist>());
+    }
+  }
+  if (!misses.empty() && !fetch) {
+    for (auto &it : misses) {
+      key.objectNo = it.first;
+      startBlockCacheFill(fr, key, layout.objectSize);
+    }
+    return false;
+  }
+  // fetch the missing objects
+  if (!misses.empty()) {
+    unsigned int cephPoolIdx;
+    librados::IoCtx *ioctx = selectIoCtx(fr, cephPoolIdx);
+    size_t fetched = misses.size() * layout.objectSize;
+    cephPoolOpStart(cephPoolIdx, fetched);
+    for (auto &it : misses) {
+      it.second.first = librados::Rados::aio_create_completion();
+      int orc = ioctx->aio_read(XrdCephStripeLayout::objectName(fr.name, it.first),
+                                it.second.first, it.second.second.get(), layout.objectSize, 0);
+      if (orc < 0) {
+        it.second.first->release();
+        it.second.first = 0;
+      }
+    }
+    bool failed = false;
+    for (auto &it : misses) {
+      if (0 == it.second.first) {
+        failed = true;
+        continue;
+      }
+      it.second.first->wait_for_complete();
+      int orc = it.second.first->get_return_value();
+      it.second.first->release();
+      if (orc < 0 && orc != -ENOENT) {
+        failed = true;
+        continue;
+      }
+      // a missing object is a hole, cached as empty
+      if (orc < 0) it.second.second->clear();
+      key.objectNo = it.first;
+      g_blockCache.put(key, it.second.second, it.second.second->length());
+      blocks[it.first] = it.second.second;
+    }
+    cephPoolOpEnd(cephPoolIdx, fetched);
+    // let the regular path report the error
+    if (failed) return false;
+  }
+  // copy out, zero filling holes
+  for (auto &p : pieces) {
+    copyFromBlock(*blocks[p.objectNo], p.objectOffset, p.buf, p.len);
+  }
+  rc = end - offset;
+  return true;
+}
+
 static int ceph_posix_internal_truncate(const CephFile &file, unsigned long long size);
+static void flushAioCoalesce(CephFileRef &fr);
+/// deadline of the drains of pending writes, none when default constructed
+typedef std::chrono::steady_clock::time_point DrainDeadline;
+static int drainWriteBehind(CephFileRef &fr, int fd,
+                            const DrainDeadline &deadline = DrainDeadline());
+static int drainAioWrites(CephFileRef &fr, const DrainDeadline &deadline = DrainDeadline());
+static void storeStreamedChecksums(CephFileRef &fr);
 
 /**
  * * brief ceph_posix_open function opens a file for read or write
@@ -655,27 +2007,53 @@ static int ceph_posix_internal_truncate(const CephFile &file, unsigned long long
 
 int ceph_posix_open(XrdOucEnv* env, const char *pathname, int flags, mode_t mode){
 
-  CephFileRef fr = getCephFileRef(pathname, env, flags, mode, 0);
+  std::unique_ptr<CephFileRef> fr(getCephFileRef(pathname, env, flags, mode, 0));
 
   struct stat buf;
-  libradosstriper::RadosStriper *striper = getRadosStriper(fr); //Get a handle to the RADOS striper API
- 
-  if (NULL == striper) {
+  //Get handles to the RADOS striper API, kept in the file reference for further I/O
+  if (0 == bindCephHandles(*fr)) {
     logwrapper((char*)"Cannot create striper");  
     return -EINVAL;
   }
  
-  int rc = striper->stat(fr.name, (uint64_t*)&(buf.st_size), &(buf.st_atime)); //Get details about a file
-  
+  int rc = -EINVAL;
+  // with fast creates, write opens start by creating the file, so that new
+  // files cost a single round trip. Existing ones go through the usual path
+  bool created = false;
+  if ((flags&O_ACCMODE) != O_RDONLY && g_fastCreate) {
+    rc = createStripedFile(*fr);
+    if (rc < 0 && rc != -EEXIST) return rc;
+    created = (0 == rc);
+  }
+  // files open for read get their layout and size in one go from their first
+  // object, so that their reads can bypass the striper. The readahead engine
+  // also needs the layout, which is then known without any further I/O
+  if ((flags&O_ACCMODE) == O_RDONLY && (g_directReads || g_readAheadWindow)) {
+    const OpenPrefetchRule *prefetch = g_directReads ? findOpenPrefetchRule(fr->name) : 0;
+    rc = loadObjectStat(*fr, prefetch ? prefetch->head : 0);
+    if (0 == rc && g_directReads) {
+      fr->directReads = true;
+      if (prefetch) startTailPrefetch(*fr, prefetch->tail);
+    }
+  }
+  if (!fr->statCached && !created && rc != -ENOENT) {
+    rc = fr->striper->stat(fr->name, (uint64_t*)&(buf.st_size), &(buf.st_atime)); //Get details about a file
+    // keep the result for further fstat calls
+    if (0 == rc) {
+      fr->statCached = true;
+      fr->size = buf.st_size;
+      fr->mtime = buf.st_atime;
+    }
+  }
  
-  bool fileExists = (rc != -ENOENT); //Make clear what condition we are testing
+  bool fileExists = (!created && rc != -ENOENT); //Make clear what condition we are testing
 
   logwrapper((char*)"Access Mode: %s flags&O_ACCMODE %d ", pathname, flags);
 
   if ((flags&O_ACCMODE) == O_RDONLY) {  // Access mode is READ
 
     if (fileExists) {
-      int fd = insertFileRef(fr);
+      int fd = insertFileRef(fr.release());
       logwrapper((char*)"File descriptor %d associated to file %s opened in read mode", fd, pathname);
       return fd;
     } else {
@@ -685,10 +2063,18 @@ int ceph_posix_open(XrdOucEnv* env, const char *pathname, int flags, mode_t mode
   } else {                              // Access mode is WRITE
     if (fileExists) {
       if (flags & O_TRUNC) {
+        // the old objects are removed before the open returns. Deferring it
+        // is not possible as the new file reuses their names : a background
+        // removal would race with the new writes, and objects left behind
+        // would show their old content in the holes of the new file
         int rc = ceph_posix_unlink(env, pathname);
         if (rc < 0 && rc != -ENOENT) {
           return rc;
         }
+        if (g_fastCreate) {
+          rc = createStripedFile(*fr);
+          if (rc < 0) return rc;
+        }
       } else {
         if (flags & O_EXCL) {
           return -EACCES; // permission denied
@@ -698,7 +2084,15 @@ int ceph_posix_open(XrdOucEnv* env, const char *pathname, int flags, mode_t mode
       }
     }
     // At this point, we know either the target file didn't exist, or the ceph_posix_unlink above removed it
-    int fd = insertFileRef(fr);
+    fr->statCached = true;
+    fr->size = 0;
+    fr->mtime = time(NULL);
+    // the file starts empty, its checksums can be streamed
+    fr->checksum.valid = g_streamAdler32 || g_streamCrc32c;
+    // cached blocks of a former file of that name are stale. Blocks cached
+    // while this one is written are dropped again at close
+    invalidateBlockCache(*fr);
+    int fd = insertFileRef(fr.release());
     logwrapper((char*)"File descriptor %d associated to file %s opened in write mode", fd, pathname);
     return fd;
     
@@ -709,25 +2103,45 @@ int ceph_posix_open(XrdOucEnv* env, const char *pathname, int flags, mode_t mode
 int ceph_posix_close(int fd) {
   CephFileRef* fr = getFileRef(fd);
   if (fr) {
+    // buffered writes are flushed first and all async writes are waited
+    // for, as their completions use the file. Their errors are reported here
+    int wbrc = drainWriteBehind(*fr, fd);
+    int aiorc = drainAioWrites(*fr);
+    if (0 == wbrc) wbrc = aiorc;
+    // failed writes may have left anything in the file
+    if (0 == wbrc) storeStreamedChecksums(*fr);
+    if (fr->flags & (O_WRONLY|O_RDWR)) invalidateBlockCache(*fr);
     ::timeval now;
     ::gettimeofday(&now, nullptr);
-    XrdSysMutexHelper lock(fr->statsMutex);
+    uint64_t lastAsyncSubmission = fr->lastAsyncSubmission;
+    ::timeval lastAsync;
+    lastAsync.tv_sec = lastAsyncSubmission / 1000000;
+    lastAsync.tv_usec = lastAsyncSubmission % 1000000;
     double lastAsyncAge = 0.0;
     // Only compute an age if the starting point was set.
-    if (fr->lastAsyncSubmission.tv_sec && fr->lastAsyncSubmission.tv_usec) {
-      lastAsyncAge = 1.0 * (now.tv_sec - fr->lastAsyncSubmission.tv_sec) 
-              + 0.000001 * (now.tv_usec - fr->lastAsyncSubmission.tv_usec);
+    if (lastAsync.tv_sec && lastAsync.tv_usec) {
+      lastAsyncAge = 1.0 * (now.tv_sec - lastAsync.tv_sec) 
+              + 0.000001 * (now.tv_usec - lastAsync.tv_usec);
     }
     logwrapper((char*)"ceph_close: closed fd %d for file %s, read ops count %d, write ops count %d, "
                "async write ops %d/%d, async pending write bytes %ld, "
                "async read ops %d/%d, bytes written/max offset %ld/%ld, "
-               "longest async write %f, longest callback invocation %f, last async op age %f", 
-               fd, fr->name.c_str(), fr->rdcount, fr->wrcount, 
-               fr->asyncWrCompletionCount, fr->asyncWrStartCount, fr->bytesAsyncWritePending,
-               fr->asyncRdCompletionCount, fr->asyncRdStartCount, fr->bytesWritten,  fr->maxOffsetWritten,
-               fr->longestAsyncWriteTime, fr->longestCallbackInvocation, (lastAsyncAge));
+               "longest async write %f, longest callback invocation %f, last async op age %f, bytes copied on read %ld, "
+               "readahead bytes fetched/served %ld/%ld, bytes read as holes %ld, "
+               "bytes served from open prefetch %ld, write throttle time %f", 
+               fd, fr->name.c_str(), fr->rdcount.load(), fr->wrcount.load(), 
+               fr->asyncWrCompletionCount.load(), fr->asyncWrStartCount.load(), fr->bytesAsyncWritePending.load(),
+               fr->asyncRdCompletionCount.load(), fr->asyncRdStartCount.load(), fr->bytesWritten.load(),  fr->maxOffsetWritten.load(),
+               fr->longestAsyncWriteTime.load(), fr->longestCallbackInvocation.load(), (lastAsyncAge),
+               fr->bytesCopiedOnRead.load(), fr->bytesReadAhead.load(), fr->bytesFromReadAhead.load(),
+               fr->bytesReadAsHoles.load(), fr->bytesFromPrefetch.load(),
+               0.000001 * fr->writeThrottleTime.load());
+    unscheduleAioCoalesce(fd);
+    flushAioCoalesce(*fr);
+    dropOpenPrefetch(*fr);
+    dropReadAhead(*fr);
     deleteFileRef(fd, *fr);
-    return 0;
+    return wbrc;
   } else {
     return -EBADF;
   }
@@ -767,6 +2181,382 @@ off64_t ceph_posix_lseek64(int fd, off64_t offset, int whence) {
   }
 }
 
+/// accounts for a successful write ending at the given offset in the locally
+/// known stat. The cached blocks of the file are dropped at open and close
+static void updateLocalStat(CephFileRef *fr, uint64_t endOffset) {
+  atomicMax(fr->size, endOffset);
+  fr->mtime = time(NULL);
+}
+
+/**
+ * prepares a bufferlist pointing directly to the caller's buffer, without
+ * copying nor owning it. For reads, librados lands the data there, for
+ * writes it sends it from there. The buffer must hence stay valid until
+ * the operation has completed, that is until the aio callback was called
+ */
+static void wrapBuffer(ceph::bufferlist &bl, const char *buf, size_t count) {
+  bl.push_back(ceph::bufferptr(ceph::buffer::create_static(count, const_cast<char*>(buf))));
+}
+
+/// folds the checksums of a piece into the ones of the piece preceding it
+static void combineChecksums(uint32_t &adler, uint32_t &crc, const StreamingChecksum::Segment &next) {
+  if (g_streamAdler32) adler = XrdCephAdler32::combine(adler, next.adler, next.len);
+  if (g_streamCrc32c) crc = XrdCephCrc32c::combine(crc, next.crc, next.len);
+}
+
+/**
+ * accounts for data written to a file in its streamed checksums. The data
+ * is checksummed outside of the lock. Rewrites of already written data
+ * cannot be streamed and stop it for the file
+ */
+static void streamChecksum(CephFileRef &fr, const char *buf, size_t count, uint64_t offset) {
+  StreamingChecksum &cks = fr.checksum;
+  if (!cks.valid || 0 == count) return;
+  StreamingChecksum::Segment seg = { count, 1, 0 };
+  if (g_streamAdler32) seg.adler = XrdCephAdler32::calc(buf, count);
+  if (g_streamCrc32c) seg.crc = XrdOucCRC::Calc32C(buf, count);
+  XrdSysMutexHelper lock(cks.mutex);
+  if (!cks.valid) return;
+  auto next = cks.segments.lower_bound(offset);
+  bool overlaps = offset < cks.prefixEnd ||
+    (next != cks.segments.end() && next->first < offset + count);
+  auto prev = next;
+  if (!overlaps && prev != cks.segments.begin()) {
+    --prev;
+    overlaps = prev->first + prev->second.len > offset;
+  } else {
+    prev = cks.segments.end();
+  }
+  if (overlaps) {
+    cks.valid = false;
+    cks.segments.clear();
+    return;
+  }
+  // merge with the following piece, then with the preceding one
+  if (next != cks.segments.end() && next->first == offset + count) {
+    combineChecksums(seg.adler, seg.crc, next->second);
+    seg.len += next->second.len;
+    cks.segments.erase(next);
+  }
+  if (prev != cks.segments.end() && prev->first + prev->second.len == offset) {
+    combineChecksums(prev->second.adler, prev->second.crc, seg);
+    prev->second.len += seg.len;
+  } else {
+    prev = cks.segments.insert(std::make_pair(offset, seg)).first;
+  }
+  // the prefix absorbs the first piece when it reaches it
+  if (prev->first == cks.prefixEnd) {
+    combineChecksums(cks.adler, cks.crc, prev->second);
+    cks.prefixEnd += prev->second.len;
+    cks.segments.erase(prev);
+  }
+  if (cks.segments.size() > g_streamMaxSegments) {
+    cks.valid = false;
+    cks.segments.clear();
+  }
+}
+
+/// stops the checksum streaming of a file, e.g. after a failed write
+static void invalidateChecksum(CephFileRef &fr) {
+  XrdSysMutexHelper lock(fr.checksum.mutex);
+  fr.checksum.valid = false;
+  fr.checksum.segments.clear();
+}
+
+/// prepares the value of the XrdCks.<name> xattr used by the xrootd checksum
+/// manager for a 32 bits checksum of a file with the given mtime
+static void makeCksXAttr(const char *name, uint32_t value, time_t mtime, ceph::bufferlist &bl) {
+  XrdCksData cks;
+  cks.Set(name);
+  unsigned char bytes[4] = { (unsigned char)(value >> 24), (unsigned char)(value >> 16),
+                             (unsigned char)(value >> 8), (unsigned char)value };
+  cks.Set(bytes, 4);
+  // times are stored in network order, csTime relative to fmTime
+  cks.fmTime = htonll((long long)mtime);
+  cks.csTime = htonl((int)(time(NULL) - mtime));
+  bl.append((const char*)&cks, sizeof(cks));
+}
+
+/**
+ * stores the streamed checksums of a file as xattrs, if the whole file was
+ * covered. They are set together with the modification time the file had,
+ * so that the checksum manager, which compares them, finds them up to date
+ */
+static void storeStreamedChecksums(CephFileRef &fr) {
+  uint32_t adler, crc;
+  {
+    XrdSysMutexHelper lock(fr.checksum.mutex);
+    if (!fr.checksum.valid) return;
+    if (!fr.checksum.segments.empty() || fr.checksum.prefixEnd != fr.size) {
+      logwrapper((char*)"ceph_close: streamed checksum of %s not stored, file not written sequentially",
+                 fr.name.c_str());
+      return;
+    }
+    // all checksummed data must have been written successfully
+    if (fr.committed.prefix() != fr.checksum.prefixEnd) {
+      logwrapper((char*)"ceph_close: streamed checksum of %s not stored, only %llu of %llu bytes committed",
+                 fr.name.c_str(), (unsigned long long)fr.committed.prefix(),
+                 (unsigned long long)fr.checksum.prefixEnd);
+      return;
+    }
+    adler = fr.checksum.adler;
+    crc = fr.checksum.crc;
+  }
+  std::string oid = XrdCephStripeLayout::objectName(fr.name, 0);
+  uint64_t size;
+  time_t mtime;
+  int rc = fr.ioctx->stat(oid, &size, &mtime);
+  if (rc < 0) return;
+  librados::ObjectWriteOperation op;
+  op.mtime(&mtime);
+  ceph::bufferlist adlerBl, crcBl;
+  if (g_streamAdler32) {
+    makeCksXAttr("adler32", adler, mtime, adlerBl);
+    op.setxattr("XrdCks.adler32", adlerBl);
+  }
+  if (g_streamCrc32c) {
+    makeCksXAttr("crc32c", crc, mtime, crcBl);
+    op.setxattr("XrdCks.crc32c", crcBl);
+  }
+  rc = fr.ioctx->operate(oid, &op);
+  if (rc < 0) {
+    logwrapper((char*)"ceph_close: could not store streamed checksums of %s, rc %d",
+               fr.name.c_str(), rc);
+  }
+}
+
+/// chunk size of the write-behind buffer of a file, 0 if not used. Only
+/// files open write only use it, so that reads never miss buffered data
+static uint64_t writeBehindChunkSize(const CephFileRef &fr) {
+  if ((fr.flags & O_ACCMODE) != O_WRONLY) return 0;
+  switch (g_writeBehindChunk) {
+  case WriteBehindStripeUnit:
+    return fr.stripeUnit;
+  case WriteBehindObjectSet:
+    return fr.objectSize * fr.nbStripes;
+  default:
+    return 0;
+  }
+}
+
+/// reserves write-behind memory under the global cap, following the
+/// overflow policy when it is reached
+static bool reserveWriteBehind(uint64_t bytes) {
+  for (unsigned int attempt = 0; ; attempt++) {
+    unsigned long long used = g_writeBehindUsed.load(std::memory_order_relaxed);
+    while (used + bytes <= g_writeBehindCapacity) {
+      if (g_writeBehindUsed.compare_exchange_weak(used, used + bytes)) return true;
+    }
+    // with the wait policy, give flushes up to a second to free memory.
+    // Buffers of idle files may never be flushed, so waiting is bounded
+    if (g_writeBehindOverflow != WriteBehindOverflowWait || attempt >= 10) {
+      g_writeBehindOverflows++;
+      return false;
+    }
+    g_writeBehindMemCond.Lock();
+    g_writeBehindMemCond.WaitMS(100);
+    g_writeBehindMemCond.UnLock();
+  }
+}
+
+static void releaseWriteBehind(uint64_t bytes) {
+  g_writeBehindUsed -= bytes;
+  g_writeBehindMemCond.Lock();
+  g_writeBehindMemCond.Broadcast();
+  g_writeBehindMemCond.UnLock();
+}
+
+/// small struct for the completion of write-behind flushes
+struct WriteBehindFlush {
+  int fd;
+  uint64_t offset;
+  uint64_t nbBytes;
+  uint64_t reserved;
+  unsigned int cephPoolIdx;
+};
+
+static void ceph_write_behind_complete(rados_completion_t c, void *arg) {
+  WriteBehindFlush *flush = reinterpret_cast<WriteBehindFlush*>(arg);
+  int rc = rados_aio_get_return_value(c);
+  cephPoolOpEnd(flush->cephPoolIdx, flush->nbBytes);
+  releaseWriteBehind(flush->reserved);
+  CephFileRef *fr = getFileRef(flush->fd);
+  if (fr) {
+    // the error may be cleared by a drain, the checksum must not survive it
+    if (rc < 0) invalidateChecksum(*fr);
+    // the file cannot be closed before this completes, but must not be
+    // used anymore once the lock is released
+    XrdSysCondVarHelper lock(fr->writeBehind.cond);
+    if (rc < 0 && 0 == fr->writeBehind.error) fr->writeBehind.error = rc;
+    if (0 == rc) fr->committed.commit(flush->offset, flush->nbBytes);
+    if (0 == --fr->writeBehind.inflight) fr->writeBehind.inflightEnd = 0;
+    fr->writeBehind.cond.Broadcast();
+  }
+  delete flush;
+}
+
+/// sends the chunk being filled asynchronously. Called with the lock of
+/// the write-behind state
+static void flushWriteBehind(CephFileRef &fr, int fd) {
+  WriteBehindState &wb = fr.writeBehind;
+  if (0 == wb.capacity) return;
+  uint64_t len = wb.len;
+  if (0 == len) {
+    releaseWriteBehind(wb.capacity);
+  } else {
+    ceph::bufferlist bl;
+    bl.push_back(ceph::bufferptr(wb.buf, 0, len));
+    unsigned int cephPoolIdx;
+    libradosstriper::RadosStriper *striper = selectStriper(fr, cephPoolIdx);
+    WriteBehindFlush *flush = new WriteBehindFlush{fd, wb.start, len, wb.capacity, cephPoolIdx};
+    librados::AioCompletion *completion =
+      selectedCluster(fr, cephPoolIdx)->aio_create_completion(flush, ceph_write_behind_complete, NULL);
+    cephPoolOpStart(cephPoolIdx, len);
+    int rc = striper->aio_write(fr.name, completion, bl, len, wb.start);
+    completion->release();
+    if (rc < 0) {
+      cephPoolOpEnd(cephPoolIdx, len);
+      releaseWriteBehind(wb.capacity);
+      if (0 == wb.error) wb.error = rc;
+      invalidateChecksum(fr);
+      delete flush;
+    } else {
+      wb.inflight++;
+      wb.inflightEnd = std::max(wb.inflightEnd, wb.start + len);
+    }
+  }
+  wb.buf = ceph::bufferptr();
+  wb.len = 0;
+  wb.capacity = 0;
+}
+
+/// waits on a condition variable locked by the caller, until the deadline
+/// if any. Returns false once the deadline passed
+static bool waitDrain(XrdSysCondVar &cond, const DrainDeadline &deadline) {
+  if (DrainDeadline() == deadline) {
+    cond.Wait();
+    return true;
+  }
+  auto left = std::chrono::duration_cast<std::chrono::milliseconds>
+    (deadline - std::chrono::steady_clock::now()).count();
+  if (left <= 0) return false;
+  cond.WaitMS(left);
+  return true;
+}
+
+/// waits for the flushes of a file in flight, until the deadline if any.
+/// Called with the lock of the write-behind state. Returns false if
+/// flushes are still in flight
+static bool waitWriteBehind(WriteBehindState &wb, const DrainDeadline &deadline = DrainDeadline()) {
+  while (wb.inflight) {
+    if (!waitDrain(wb.cond, deadline)) return false;
+  }
+  return true;
+}
+
+/**
+ * flushes the write-behind buffer of a file and waits for all its flushes,
+ * until the deadline if any. Returns the first error met by a flush since
+ * the last call, if any, or -ETIMEDOUT if flushes are still in flight
+ */
+static int drainWriteBehind(CephFileRef &fr, int fd, const DrainDeadline &deadline) {
+  WriteBehindState &wb = fr.writeBehind;
+  XrdSysCondVarHelper lock(wb.cond);
+  flushWriteBehind(fr, fd);
+  if (!waitWriteBehind(wb, deadline)) return -ETIMEDOUT;
+  int rc = wb.error;
+  wb.error = 0;
+  return rc;
+}
+
+/// marks a write going through the write-behind buffer of a file, for the
+/// scope of the object, waiting for the previous one to be done. Created
+/// and destroyed with the lock of the write-behind state
+struct WriteBehindWriter {
+  WriteBehindWriter(WriteBehindState &wb) : m_wb(wb) {
+    while (m_wb.writing) m_wb.cond.Wait();
+    m_wb.writing = true;
+  }
+  ~WriteBehindWriter() {
+    m_wb.writing = false;
+    m_wb.cond.Broadcast();
+  }
+  WriteBehindState &m_wb;
+};
+
+/**
+ * Tries to absorb a write in the write-behind buffer of the file. Contiguous
+ * writes are aggregated in chunks ending on chunk boundaries, each full chunk
+ * being sent asynchronously as a single aligned write. A non contiguous
+ * write flushes the current chunk first, and waits for flushes in flight
+ * when going backwards, so that overlapping writes stay ordered. Whatever
+ * does not fit under the memory cap is written synchronously, after the
+ * overlapping flushes in flight. Neither waiting for memory nor writing
+ * synchronously hold the lock of the write-behind state, which the
+ * completions of the flushes take, but the other writes of the file wait.
+ * Returns false if the file does not use write-behind, in which case rc is
+ * not set. Otherwise rc is count or a negative errno, possibly from an
+ * earlier flush
+ */
+static bool writeBehind(CephFileRef &fr, int fd, const char *buf, size_t count,
+                        uint64_t offset, ssize_t &rc) {
+  uint64_t chunk = writeBehindChunkSize(fr);
+  if (0 == chunk) return false;
+  WriteBehindState &wb = fr.writeBehind;
+  XrdSysCondVarHelper lock(wb.cond);
+  WriteBehindWriter writer(wb);
+  if (wb.error) {
+    rc = wb.error;
+    wb.error = 0;
+    return true;
+  }
+  if (wb.len && offset != wb.start + wb.len) flushWriteBehind(fr, fd);
+  if (offset < wb.inflightEnd) waitWriteBehind(wb);
+  size_t done = 0;
+  while (done < count) {
+    uint64_t pos = offset + done;
+    if (0 == wb.capacity) {
+      // new chunk, up to the next chunk boundary
+      uint64_t size = chunk - pos % chunk;
+      wb.cond.UnLock();
+      bool reserved = reserveWriteBehind(size);
+      wb.cond.Lock();
+      if (!reserved) {
+        if (pos < wb.inflightEnd) waitWriteBehind(wb);
+        wb.cond.UnLock();
+        ceph::bufferlist bl;
+        wrapBuffer(bl, buf + done, count - done);
+        unsigned int cephPoolIdx;
+        libradosstriper::RadosStriper *striper = selectStriper(fr, cephPoolIdx);
+        cephPoolOpStart(cephPoolIdx, count - done);
+        int wrc = striper->write(fr.name, bl, count - done, pos);
+        cephPoolOpEnd(cephPoolIdx, count - done);
+        wb.cond.Lock();
+        if (wrc) {
+          invalidateChecksum(fr);
+          rc = wrc;
+          return true;
+        }
+        fr.committed.commit(pos, count - done);
+        break;
+      }
+      wb.buf = ceph::bufferptr(size);
+      wb.start = pos;
+      wb.capacity = size;
+    }
+    uint64_t n = std::min((uint64_t)(count - done), wb.capacity - wb.len);
+    memcpy(wb.buf.c_str() + wb.len, buf + done, n);
+    wb.len += n;
+    done += n;
+    if (wb.len == wb.capacity) flushWriteBehind(fr, fd);
+  }
+  fr.bytesWritten += count;
+  if (offset + count) atomicMax(fr.maxOffsetWritten, (uint64_t)(offset + count - 1));
+  updateLocalStat(&fr, offset + count);
+  rc = count;
+  return true;
+}
+
 ssize_t ceph_posix_write(int fd, const void *buf, size_t count) {
   CephFileRef* fr = getFileRef(fd);
   if (fr) {
@@ -774,19 +2564,31 @@ ssize_t ceph_posix_write(int fd, const void *buf, size_t count) {
     if ((fr->flags & (O_WRONLY|O_RDWR)) == 0) {
       return -EBADF;
     }
-    libradosstriper::RadosStriper *striper = getRadosStriper(*fr);
-    if (0 == striper) {
-      return -EINVAL;
+    streamChecksum(*fr, (const char*)buf, count, fr->offset);
+    ssize_t wbrc;
+    if (writeBehind(*fr, fd, (const char*)buf, count, fr->offset, wbrc)) {
+      if (wbrc < 0) return wbrc;
+      fr->offset += count;
+      fr->wrcount++;
+      return count;
     }
     ceph::bufferlist bl;
-    bl.append((const char*)buf, count);
+    wrapBuffer(bl, (const char*)buf, count);
+    unsigned int cephPoolIdx;
+    libradosstriper::RadosStriper *striper = selectStriper(*fr, cephPoolIdx);
+    cephPoolOpStart(cephPoolIdx, count);
     int rc = striper->write(fr->name, bl, count, fr->offset);
-    if (rc) return rc;
+    cephPoolOpEnd(cephPoolIdx, count);
+    if (rc) {
+      invalidateChecksum(*fr);
+      return rc;
+    }
+    fr->committed.commit(fr->offset, count);
     fr->offset += count;
-    XrdSysMutexHelper lock(fr->statsMutex);
     fr->wrcount++;
     fr->bytesWritten+=count;
-    if (fr->offset) fr->maxOffsetWritten = std::max(fr->offset - 1, fr->maxOffsetWritten);
+    if (fr->offset) atomicMax(fr->maxOffsetWritten, fr->offset - 1);
+    updateLocalStat(fr, fr->offset);
     return count;
   } else {
     return -EBADF;
@@ -801,41 +2603,155 @@ ssize_t ceph_posix_pwrite(int fd, const void *buf, size_t count, off64_t offset)
     if ((fr->flags & (O_WRONLY|O_RDWR)) == 0) {
       return -EBADF;
     }
-    libradosstriper::RadosStriper *striper = getRadosStriper(*fr);
-    if (0 == striper) {
-      return -EINVAL;
+    streamChecksum(*fr, (const char*)buf, count, offset);
+    ssize_t wbrc;
+    if (writeBehind(*fr, fd, (const char*)buf, count, offset, wbrc)) {
+      if (wbrc < 0) return wbrc;
+      fr->wrcount++;
+      return count;
     }
     ceph::bufferlist bl;
-    bl.append((const char*)buf, count);
+    wrapBuffer(bl, (const char*)buf, count);
+    unsigned int cephPoolIdx;
+    libradosstriper::RadosStriper *striper = selectStriper(*fr, cephPoolIdx);
+    cephPoolOpStart(cephPoolIdx, count);
     int rc = striper->write(fr->name, bl, count, offset);
-    if (rc) return rc;
-    XrdSysMutexHelper lock(fr->statsMutex);
+    cephPoolOpEnd(cephPoolIdx, count);
+    if (rc) {
+      invalidateChecksum(*fr);
+      return rc;
+    }
+    fr->committed.commit(offset, count);
     fr->wrcount++;
     fr->bytesWritten+=count;
-    if (offset + count) fr->maxOffsetWritten = std::max(offset + count - 1, fr->maxOffsetWritten);
+    if (offset + count) atomicMax(fr->maxOffsetWritten, (uint64_t)(offset + count - 1));
+    updateLocalStat(fr, offset + count);
     return count;
   } else {
     return -EBADF;
   }
 }
 
+/// checks whether an async write fits in one in flight limit, the first
+/// write always fitting so that writes larger than the limit can proceed
+static inline bool fitsInFlight(uint64_t inflight, uint64_t more, uint64_t limit) {
+  return 0 == limit || 0 == inflight || inflight + more <= limit;
+}
+
+/// admits an async write if it fits in all in flight limits. All counters
+/// are reserved first and given back if over a limit, so that concurrent
+/// writes cannot all pass the checks
+static bool tryAdmitAsyncWrite(CephFileRef &fr, uint64_t count) {
+  uint64_t fileBytes = fr.aioWriteInflightBytes.fetch_add(count);
+  unsigned int fileOps = fr.aioWriteInflightOps.fetch_add(1);
+  uint64_t bytes = g_aioWriteInflightBytes.fetch_add(count);
+  unsigned int ops = g_aioWriteInflightOps.fetch_add(1);
+  if (!fitsInFlight(fileBytes, count, g_aioWriteFileMaxBytes) ||
+      !fitsInFlight(fileOps, 1, g_aioWriteFileMaxOps) ||
+      !fitsInFlight(bytes, count, g_aioWriteMaxBytes) ||
+      !fitsInFlight(ops, 1, g_aioWriteMaxOps)) {
+    g_aioWriteInflightBytes -= count;
+    g_aioWriteInflightOps--;
+    fr.aioWriteInflightBytes -= count;
+    fr.aioWriteInflightOps--;
+    return false;
+  }
+  return true;
+}
+
+/// accounts for the end of an admitted async write and wakes up the
+/// writes waiting for room
+static void releaseAsyncWrite(CephFileRef *fr, uint64_t count) {
+  g_aioWriteInflightBytes -= count;
+  g_aioWriteInflightOps--;
+  if (fr) {
+    fr->aioWriteInflightBytes -= count;
+    fr->aioWriteInflightOps--;
+  }
+  g_aioWriteCond.Lock();
+  g_aioWriteCond.Broadcast();
+  g_aioWriteCond.UnLock();
+}
+
+/**
+ * applies the in flight limits to an async write. Returns true once the
+ * write is admitted, possibly after blocking until enough writes completed,
+ * and false if it has to be done synchronously. Time spent throttled is
+ * accounted globally and per file
+ */
+static bool admitAsyncWrite(CephFileRef &fr, uint64_t count) {
+  if (tryAdmitAsyncWrite(fr, count)) return true;
+  g_aioWriteThrottled++;
+  if (AioWriteOverflowSync == g_aioWriteOverflow) return false;
+  auto start = std::chrono::steady_clock::now();
+  g_aioWriteCond.Lock();
+  while (!tryAdmitAsyncWrite(fr, count)) {
+    // completions broadcast under the lock, but admissions giving back their
+    // reservation do not, and may have been the only reason to fail
+    g_aioWriteCond.WaitMS(100);
+  }
+  g_aioWriteCond.UnLock();
+  uint64_t waited = std::chrono::duration_cast<std::chrono::microseconds>
+    (std::chrono::steady_clock::now() - start).count();
+  g_aioWriteThrottleTime += waited;
+  fr.writeThrottleTime += waited;
+  return true;
+}
+
+/// accounts for an async write being submitted
+static void startAioWrite(CephFileRef &fr) {
+  XrdSysCondVarHelper lock(fr.aioWrites.cond);
+  fr.aioWrites.pending++;
+}
+
+/// accounts for an async write being done, keeping its error if first. The
+/// file may be closed as soon as this returns, it must not be used anymore
+static void endAioWrite(CephFileRef &fr, int rc) {
+  XrdSysCondVarHelper lock(fr.aioWrites.cond);
+  if (rc < 0 && 0 == fr.aioWrites.error) fr.aioWrites.error = rc;
+  if (0 == --fr.aioWrites.pending) fr.aioWrites.cond.Broadcast();
+}
+
+/**
+ * waits for all async writes of a file to complete, until the deadline if
+ * any. Returns the first error of an async write since the last call, or
+ * -ETIMEDOUT if writes are still pending
+ */
+static int drainAioWrites(CephFileRef &fr, const DrainDeadline &deadline) {
+  XrdSysCondVarHelper lock(fr.aioWrites.cond);
+  while (fr.aioWrites.pending) {
+    if (!waitDrain(fr.aioWrites.cond, deadline)) return -ETIMEDOUT;
+  }
+  int rc = fr.aioWrites.error;
+  fr.aioWrites.error = 0;
+  return rc;
+}
+
 static void ceph_aio_write_complete(rados_completion_t c, void *arg) {
   AioArgs *awa = reinterpret_cast<AioArgs*>(arg);
   size_t rc = rados_aio_get_return_value(c);
+  cephPoolOpEnd(awa->cephPoolIdx, awa->nbBytes);
   // Compute statistics before reportng to xrootd, so that a close cannot happen
   // in the meantime.
   CephFileRef* fr = getFileRef(awa->fd);
+  if (g_aioWriteLimited) releaseAsyncWrite(fr, awa->nbBytes);
   if (fr) {
-    XrdSysMutexHelper lock(fr->statsMutex);
     fr->asyncWrCompletionCount++;
     fr->bytesAsyncWritePending -= awa->nbBytes;
     fr->bytesWritten += awa->nbBytes;
     if (awa->aiop->sfsAio.aio_nbytes)
-      fr->maxOffsetWritten = std::max(fr->maxOffsetWritten, awa->aiop->sfsAio.aio_offset + awa->aiop->sfsAio.aio_nbytes - 1);
+      atomicMax(fr->maxOffsetWritten, (uint64_t)(awa->aiop->sfsAio.aio_offset + awa->aiop->sfsAio.aio_nbytes - 1));
+    if (0 == rc) {
+      fr->committed.commit(awa->aiop->sfsAio.aio_offset, awa->aiop->sfsAio.aio_nbytes);
+      updateLocalStat(fr, awa->aiop->sfsAio.aio_offset + awa->aiop->sfsAio.aio_nbytes);
+    } else {
+      // the error may be cleared by an fsync, the checksum must not survive it
+      invalidateChecksum(*fr);
+    }
     ::timeval now;
     ::gettimeofday(&now, nullptr);
     double writeTime = 0.000001 * (now.tv_usec - awa->startTime.tv_usec) + 1.0 * (now.tv_sec - awa->startTime.tv_sec);
-    fr->longestAsyncWriteTime = std::max(fr->longestAsyncWriteTime, writeTime);
+    atomicMax(fr->longestAsyncWriteTime, writeTime);
   }
   ::timeval before, after;
   if (fr) ::gettimeofday(&before, nullptr);
@@ -843,8 +2759,9 @@ static void ceph_aio_write_complete(rados_completion_t c, void *arg) {
   if (fr) {
     ::gettimeofday(&after, nullptr);
     double callbackInvocationTime = 0.000001 * (after.tv_usec - before.tv_usec) + 1.0 * (after.tv_sec - before.tv_sec);
-    XrdSysMutexHelper lock(fr->statsMutex);
-    fr->longestCallbackInvocation = std::max(fr->longestCallbackInvocation, callbackInvocationTime);
+    atomicMax(fr->longestCallbackInvocation, callbackInvocationTime);
+    // last use of the file, a close may be waiting for this
+    endAioWrite(*fr, (int)rc);
   }
   delete(awa);
 }
@@ -861,31 +2778,65 @@ ssize_t ceph_aio_write(int fd, XrdSfsAio *aiop, AioCB *cb) {
     if ((fr->flags & (O_WRONLY|O_RDWR)) == 0) {
       return -EBADF;
     }
-    // get the striper object
-    libradosstriper::RadosStriper *striper = getRadosStriper(*fr);
-    if (0 == striper) {
-      return -EINVAL;
+    streamChecksum(*fr, buf, count, offset);
+    // buffered writes are copied, so xrootd gets its buffer back right away
+    ssize_t wbrc;
+    if (writeBehind(*fr, fd, buf, count, offset, wbrc)) {
+      fr->asyncWrStartCount++;
+      fr->asyncWrCompletionCount++;
+      cb(aiop, wbrc < 0 ? wbrc : count);
+      return 0;
     }
-    // prepare a bufferlist around the given buffer
+    // prepare a bufferlist around the given buffer. It is not copied as
+    // xrootd keeps it alive until doneWrite is called by our callback
     ceph::bufferlist bl;
-    bl.append(buf, count);
-    // get the poolIdx to use
-    int cephPoolIdx = getCephPoolIdxAndIncrease();
-    // Get the cluster to use
-    librados::Rados* cluster = checkAndCreateCluster(cephPoolIdx);
-    if (0 == cluster) {
-      return -EINVAL;
+    wrapBuffer(bl, buf, count);
+    // select the pool entry to use
+    unsigned int cephPoolIdx;
+    libradosstriper::RadosStriper *striper = selectStriper(*fr, cephPoolIdx);
+    // over the in flight limits, either wait for room or write synchronously
+    if (g_aioWriteLimited && !admitAsyncWrite(*fr, count)) {
+      auto start = std::chrono::steady_clock::now();
+      cephPoolOpStart(cephPoolIdx, count);
+      int rc = striper->write(fr->name, bl, count, offset);
+      cephPoolOpEnd(cephPoolIdx, count);
+      uint64_t took = std::chrono::duration_cast<std::chrono::microseconds>
+        (std::chrono::steady_clock::now() - start).count();
+      g_aioWriteThrottleTime += took;
+      fr->writeThrottleTime += took;
+      fr->asyncWrStartCount++;
+      fr->asyncWrCompletionCount++;
+      if (0 == rc) {
+        fr->bytesWritten += count;
+        if (count) atomicMax(fr->maxOffsetWritten, (uint64_t)(offset + count - 1));
+        fr->committed.commit(offset, count);
+        updateLocalStat(fr, offset + count);
+      } else {
+        invalidateChecksum(*fr);
+      }
+      cb(aiop, rc ? (ssize_t)rc : (ssize_t)count);
+      return 0;
     }
     // prepare a ceph AioCompletion object and do async call
-    AioArgs *args = new AioArgs(aiop, cb, count, fd);
+    AioArgs *args = new AioArgs(aiop, cb, count, fd, cephPoolIdx);
     librados::AioCompletion *completion =
-      cluster->aio_create_completion(args, ceph_aio_write_complete, NULL);
+      selectedCluster(*fr, cephPoolIdx)->aio_create_completion(args, ceph_aio_write_complete, NULL);
     // do the write
+    cephPoolOpStart(cephPoolIdx, count);
+    startAioWrite(*fr);
     int rc = striper->aio_write(fr->name, completion, bl, count, offset);
     completion->release();
-    XrdSysMutexHelper lock(fr->statsMutex);
+    if (rc < 0) {
+      cephPoolOpEnd(cephPoolIdx, count);
+      if (g_aioWriteLimited) releaseAsyncWrite(fr, count);
+      // not reported as an async error, the caller gets it right away
+      endAioWrite(*fr, 0);
+      invalidateChecksum(*fr);
+    }
     fr->asyncWrStartCount++;
-    ::gettimeofday(&fr->lastAsyncSubmission, nullptr);
+    ::timeval now;
+    ::gettimeofday(&now, nullptr);
+    fr->lastAsyncSubmission = timevalToMicroseconds(now);
     fr->bytesAsyncWritePending+=count;
     return rc;
   } else {
@@ -893,6 +2844,638 @@ ssize_t ceph_aio_write(int fd, XrdSfsAio *aiop, AioCB *cb) {
   }
 }
 
+/**
+ * makes sure the len bytes read into bl end up in buf. This is a no-op when
+ * librados used the buffer provided by wrapBuffer, and a copy when
+ * it returned its own (e.g. fragmented) buffers. Copied bytes are accounted
+ */
+static void completeReadBuffer(CephFileRef *fr, ceph::bufferlist &bl, char *buf, size_t len) {
+  if (0 == len || bl.is_provided_buffer(buf)) return;
+  bl.begin().copy(len, buf);
+  if (fr) fr->bytesCopiedOnRead += len;
+}
+
+/// a piece of a read lying in a single RADOS object
+struct ObjectExtent {
+  char *buf;
+  uint64_t objectOffset;
+  uint64_t len;
+  ceph::bufferlist bl;
+  int rval;
+  // allocated extents (offset, length) returned by a sparse read, their
+  // data being concatenated in bl
+  std::map<uint64_t, uint64_t> sparse;
+};
+
+struct ObjectReadRequest;
+
+/// all pieces of a read lying in a given RADOS object
+struct ObjectRead {
+  ObjectRead() : request(0) {}
+  ObjectReadRequest *request;
+  std::vector<ObjectExtent> extents;
+  librados::ObjectReadOperation op;
+};
+
+/// an xrootd aio read served by an ObjectReadRequest
+struct ObjectReadCaller {
+  XrdSfsAio *aiop;
+  AioCB *callback;
+  uint64_t nbBytes;
+};
+
+/// a read of pieces of a file sent directly to its RADOS objects, bypassing
+/// the striper. All objects are read in parallel, with one operation each.
+/// Asynchronous requests carry the xrootd aios they serve (several of them
+/// when coalesced), and are deleted once their last object completed
+struct ObjectReadRequest {
+  ObjectReadRequest(CephFileRef *_fr, int _fd = -1) :
+    fr(_fr), fd(_fd), nbBytes(0), cephPoolIdx(0), pending(0), rc(0), waiter(0) {}
+  // the file is used as is by synchronous requests, whose caller keeps it
+  // open. Asynchronous ones may complete after the close and look it up by fd
+  CephFileRef *fr;
+  int fd;
+  uint64_t nbBytes;
+  unsigned int cephPoolIdx;
+  std::map<uint64_t, ObjectRead> objects;
+  std::atomic<unsigned int> pending;
+  std::atomic<int> rc;
+  std::vector<ObjectReadCaller> callers;
+  // posted when the last object of a synchronous request is done
+  XrdSysSemaphore *waiter;
+};
+
+/// adds to a request the read of [offset, offset+len[ of the file into buf,
+/// merging pieces contiguous in both the object and the destination buffer
+static void addObjectReads(const XrdCephStripeLayout &layout, ObjectReadRequest &req,
+                           char *buf, uint64_t offset, uint64_t len) {
+  layout.map(offset, len,
+             [&](uint64_t objectNo, uint64_t objectOffset, uint64_t fileOffset, uint64_t l) {
+               ObjectRead &obj = req.objects[objectNo];
+               obj.request = &req;
+               char *dest = buf + (fileOffset - offset);
+               if (!obj.extents.empty() &&
+                   obj.extents.back().objectOffset + obj.extents.back().len == objectOffset &&
+                   obj.extents.back().buf + obj.extents.back().len == dest) {
+                 obj.extents.back().len += l;
+               } else {
+                 ObjectExtent e;
+                 e.buf = dest;
+                 e.objectOffset = objectOffset;
+                 e.len = l;
+                 e.rval = 0;
+                 obj.extents.push_back(e);
+               }
+             });
+  req.nbBytes += len;
+}
+
+/**
+ * scatters the result of a sparse read in the destination buffer of the
+ * extent, zero filling what lies between the allocated extents.
+ * Returns the number of bytes served as holes
+ */
+static uint64_t completeSparseRead(CephFileRef *fr, ObjectExtent &e) {
+  uint64_t end = e.objectOffset + e.len;
+  uint64_t pos = e.objectOffset;
+  uint64_t dataOffset = 0;
+  uint64_t holes = 0;
+  for (auto &m : e.sparse) {
+    uint64_t start = std::max(m.first, pos);
+    uint64_t stop = std::min(m.first + m.second, end);
+    if (start >= stop) {
+      dataOffset += m.second;
+      continue;
+    }
+    memset(e.buf + (pos - e.objectOffset), 0, start - pos);
+    holes += start - pos;
+    // never trust the map beyond the data actually returned
+    uint64_t avail = e.bl.length() > dataOffset + (start - m.first) ?
+      e.bl.length() - dataOffset - (start - m.first) : 0;
+    uint64_t n = std::min(stop - start, avail);
+    if (n) e.bl.copy(dataOffset + (start - m.first), n, e.buf + (start - e.objectOffset));
+    if (fr) fr->bytesCopiedOnRead += n;
+    memset(e.buf + (start - e.objectOffset) + n, 0, (stop - start) - n);
+    holes += (stop - start) - n;
+    pos = stop;
+    dataOffset += m.second;
+  }
+  memset(e.buf + (pos - e.objectOffset), 0, end - pos);
+  holes += end - pos;
+  return holes;
+}
+
+/// scatters the result of the read of an object in the destination buffers.
+/// Holes (missing object, object shorter than the extent or unallocated
+/// parts of a sparse read) are zero filled, and accounted
+static void completeObjectRead(CephFileRef *fr, ObjectRead &obj, int orc) {
+  uint64_t holes = 0;
+  for (auto &e : obj.extents) {
+    if (-ENOENT == orc) {
+      // missing object inside the file, this is a hole
+      memset(e.buf, 0, e.len);
+      holes += e.len;
+      continue;
+    }
+    if (orc < 0 || e.rval < 0) {
+      int expected = 0;
+      obj.request->rc.compare_exchange_strong(expected, orc < 0 ? orc : e.rval);
+      continue;
+    }
+    if (g_sparseReads) {
+      holes += completeSparseRead(fr, e);
+      continue;
+    }
+    uint64_t got = std::min((uint64_t)e.bl.length(), e.len);
+    completeReadBuffer(fr, e.bl, e.buf, got);
+    if (got < e.len) {
+      memset(e.buf + got, 0, e.len - got);
+      holes += e.len - got;
+    }
+  }
+  if (fr && holes) fr->bytesReadAsHoles += holes;
+}
+
+/// file of a request, null if it was closed meanwhile
+static CephFileRef* requestFile(ObjectReadRequest *req) {
+  return req->callers.empty() ? req->fr : getFileRef(req->fd);
+}
+
+/// accounts for an object of a request being done. When it was the last
+/// one, a synchronous request is woken up, and an asynchronous one is
+/// reported to xrootd and deleted
+static void objectReadDone(ObjectReadRequest *req) {
+  if (1 != req->pending.fetch_sub(1)) return;
+  if (req->callers.empty()) {
+    req->waiter->Post();
+    return;
+  }
+  cephPoolOpEnd(req->cephPoolIdx, req->nbBytes);
+  CephFileRef* fr = requestFile(req);
+  if (fr) {
+    fr->asyncRdCompletionCount += req->callers.size();
+  }
+  int rc = req->rc;
+  for (auto &caller : req->callers) {
+    caller.callback(caller.aiop, rc < 0 ? rc : caller.nbBytes);
+  }
+  delete req;
+}
+
+static void ceph_object_read_complete(rados_completion_t c, void *arg) {
+  ObjectRead *obj = reinterpret_cast<ObjectRead*>(arg);
+  ObjectReadRequest *req = obj->request;
+  completeObjectRead(requestFile(req), *obj, rados_aio_get_return_value(c));
+  objectReadDone(req);
+}
+
+/// fills the operation reading the pieces of an object
+static void prepareObjectRead(ObjectRead &obj) {
+  for (auto &e : obj.extents) {
+    if (g_sparseReads) {
+      // the data of the allocated extents comes packed, no zero copy here
+      obj.op.sparse_read(e.objectOffset, e.len, &e.sparse, &e.bl, &e.rval);
+    } else {
+      wrapBuffer(e.bl, e.buf, e.len);
+      obj.op.read(e.objectOffset, e.len, &e.bl, &e.rval);
+    }
+  }
+}
+
+/// accounts for an object of the tail prefetch being done, the last one
+/// making the tail usable
+static void tailPrefetchDone(ObjectReadRequest *req) {
+  if (1 != req->pending.fetch_sub(1)) return;
+  OpenPrefetch &p = req->fr->prefetch;
+  p.tailCond.Lock();
+  p.tailDone.store(true, std::memory_order_release);
+  p.tailCond.Broadcast();
+  p.tailCond.UnLock();
+}
+
+static void ceph_tail_prefetch_complete(rados_completion_t c, void *arg) {
+  ObjectRead *obj = reinterpret_cast<ObjectRead*>(arg);
+  completeObjectRead(obj->request->fr, *obj, rados_aio_get_return_value(c));
+  tailPrefetchDone(obj->request);
+}
+
+/// starts the prefetch of the tail of a file whose size and layout are
+/// known. Like the head, it is read from the objects of the file
+static void startTailPrefetch(CephFileRef &fr, uint64_t tail) {
+  uint64_t size = fr.size;
+  uint64_t headLen = fr.prefetch.head.length();
+  if (0 == tail || size <= headLen) return;
+  OpenPrefetch &p = fr.prefetch;
+  p.tailLen = std::min(tail, size - headLen);
+  p.tailOffset = size - p.tailLen;
+  p.tail = new char[p.tailLen];
+  ObjectReadRequest *req = new ObjectReadRequest(&fr);
+  addObjectReads(fr.stripeLayout, *req, p.tail, p.tailOffset, p.tailLen);
+  p.tailRequest = req;
+  // the extra count is only dropped once all objects are submitted
+  req->pending = req->objects.size() + 1;
+  for (auto &it : req->objects) {
+    ObjectRead &obj = it.second;
+    prepareObjectRead(obj);
+    librados::AioCompletion *completion =
+      fr.cluster->aio_create_completion(&obj, ceph_tail_prefetch_complete, NULL);
+    int orc = fr.ioctx->aio_operate(XrdCephStripeLayout::objectName(fr.name, it.first),
+                                    completion, &obj.op, g_readFlags, 0);
+    completion->release();
+    if (orc < 0) {
+      completeObjectRead(&fr, obj, orc);
+      tailPrefetchDone(req);
+    }
+  }
+  tailPrefetchDone(req);
+}
+
+/// waits for the tail prefetch of a file and drops what was prefetched
+static void dropOpenPrefetch(CephFileRef &fr) {
+  OpenPrefetch &p = fr.prefetch;
+  if (p.tailRequest) {
+    p.tailCond.Lock();
+    while (!p.tailDone) p.tailCond.Wait();
+    p.tailCond.UnLock();
+    delete p.tailRequest;
+    p.tailRequest = 0;
+    delete[] p.tail;
+    p.tail = 0;
+  }
+  p.head.clear();
+}
+
+/**
+ * Tries to serve a read from the head or tail of the file prefetched at
+ * open. Only reads fully inside one of them are served. When the tail is
+ * still in flight, the read waits for it if wait is set, and is left to
+ * the cluster otherwise. Returns false if the read has to be sent to the
+ * cluster, in which case rc is not set. Otherwise rc is the number of bytes read
+ */
+static bool prefetchRead(CephFileRef &fr, char *buf, size_t count, uint64_t offset,
+                         bool wait, ssize_t &rc) {
+  if (0 == count) return false;
+  OpenPrefetch &p = fr.prefetch;
+  if (offset + count <= p.head.length()) {
+    p.head.copy(offset, count, buf);
+    rc = count;
+  } else if (p.tailRequest && offset >= p.tailOffset) {
+    if (!p.tailDone.load(std::memory_order_acquire)) {
+      if (!wait) return false;
+      p.tailCond.Lock();
+      while (!p.tailDone) p.tailCond.Wait();
+      p.tailCond.UnLock();
+    }
+    if (p.tailRequest->rc < 0 || offset + count > p.tailOffset + p.tailLen) {
+      // reads extending past the end of file are also left to the cluster
+      return false;
+    }
+    memcpy(buf, p.tail + (offset - p.tailOffset), count);
+    rc = count;
+  } else {
+    return false;
+  }
+  fr.bytesFromPrefetch += count;
+  return true;
+}
+
+struct HedgedObjectRead;
+
+/// one attempt at reading the pieces of an object. Attempts read into their
+/// own buffers, as the losing one may complete after the caller's buffer
+/// was handed back to xrootd
+struct ObjectReadAttempt {
+  std::shared_ptr<HedgedObjectRead> self;
+  librados::ObjectReadOperation op;
+  std::vector<ceph::bufferlist> bls;
+  std::vector<int> rvals;
+  std::vector<std::map<uint64_t, uint64_t> > sparse;
+  bool isHedge;
+};
+
+/**
+ * read of an object whose first attempt may be hedged by a second one sent
+ * to another replica. Whatever is needed to submit an attempt is copied
+ * here, as the ObjectRead and its request are only valid until the first
+ * attempt completed
+ */
+struct HedgedObjectRead : XrdCephHedged {
+  ObjectRead *obj;
+  librados::IoCtx *ioctx;
+  std::string oid;
+  std::vector<std::pair<uint64_t, uint64_t> > pieces;
+  std::chrono::steady_clock::time_point start;
+  ObjectReadAttempt attempts[2];
+  void hedge() override;
+  int submit(ObjectReadAttempt &attempt, int flags);
+};
+
+/// accounts for an attempt being over. The first successful one completes
+/// the read, a failed one only does when no other attempt is in flight
+static void finishHedgedAttempt(HedgedObjectRead &h, ObjectReadAttempt &attempt, int orc) {
+  // a missing object is a hole, not a failure
+  bool failed = orc < 0 && -ENOENT != orc;
+  if (!h.finish(failed)) return;
+  if (attempt.isHedge && !failed) g_hedger.won();
+  ObjectRead &obj = *h.obj;
+  for (size_t i = 0; i < obj.extents.size(); i++) {
+    obj.extents[i].bl = std::move(attempt.bls[i]);
+    obj.extents[i].rval = attempt.rvals[i];
+    obj.extents[i].sparse.swap(attempt.sparse[i]);
+  }
+  ObjectReadRequest *req = obj.request;
+  completeObjectRead(requestFile(req), obj, orc);
+  objectReadDone(req);
+}
+
+static void ceph_hedged_read_complete(rados_completion_t c, void *arg) {
+  ObjectReadAttempt *attempt = reinterpret_cast<ObjectReadAttempt*>(arg);
+  // keeps the read alive until the end of this callback
+  std::shared_ptr<HedgedObjectRead> h = std::move(attempt->self);
+  int orc = rados_aio_get_return_value(c);
+  if (!attempt->isHedge) {
+    g_hedger.record(std::chrono::duration_cast<std::chrono::microseconds>
+                    (std::chrono::steady_clock::now() - h->start).count());
+  }
+  finishHedgedAttempt(*h, *attempt, orc);
+}
+
+/// submits an attempt with the given librados flags
+int HedgedObjectRead::submit(ObjectReadAttempt &attempt, int flags) {
+  attempt.bls.resize(pieces.size());
+  attempt.rvals.resize(pieces.size(), 0);
+  attempt.sparse.resize(pieces.size());
+  for (size_t i = 0; i < pieces.size(); i++) {
+    if (g_sparseReads) {
+      attempt.op.sparse_read(pieces[i].first, pieces[i].second, &attempt.sparse[i],
+                             &attempt.bls[i], &attempt.rvals[i]);
+    } else {
+      attempt.op.read(pieces[i].first, pieces[i].second, &attempt.bls[i], &attempt.rvals[i]);
+    }
+  }
+  attempt.self = std::static_pointer_cast<HedgedObjectRead>(shared_from_this());
+  librados::AioCompletion *completion =
+    librados::Rados::aio_create_completion(&attempt, ceph_hedged_read_complete, NULL);
+  int rc = ioctx->aio_operate(oid, completion, &attempt.op, flags, 0);
+  completion->release();
+  if (rc < 0) attempt.self.reset();
+  return rc;
+}
+
+/// second attempt, on any replica
+void HedgedObjectRead::hedge() {
+  attempts[1].isHedge = true;
+  int rc = submit(attempts[1], librados::OPERATION_BALANCE_READS);
+  // the first attempt may have failed already and be waiting for this one
+  if (rc < 0) finishHedgedAttempt(*this, attempts[1], rc);
+}
+
+/**
+ * sends the read of an object as a hedged read. Returns a negative errno if
+ * the first attempt could not be submitted, in which case nothing is left
+ * in flight
+ */
+static int hedgedObjectRead(librados::IoCtx *ioctx, const std::string &oid, ObjectRead &obj) {
+  std::shared_ptr<HedgedObjectRead> h = std::make_shared<HedgedObjectRead>();
+  h->obj = &obj;
+  h->ioctx = ioctx;
+  h->oid = oid;
+  for (auto &e : obj.extents) {
+    h->pieces.push_back(std::make_pair(e.objectOffset, e.len));
+  }
+  h->start = std::chrono::steady_clock::now();
+  h->attempts[0].isHedge = false;
+  int rc = h->submit(h->attempts[0], g_readFlags);
+  if (rc < 0) return rc;
+  g_hedger.watch(h);
+  return 0;
+}
+
+/**
+ * sends a request to the objects of the file. Objects held by the block
+ * cache are served from it, and the others are hedged reads when hedging
+ * is enabled.
+ * Synchronous requests (no callers) are waited for, and the number of bytes
+ * read or a negative errno is returned. For asynchronous ones, 0 is
+ * returned and the request is owned by the completions from then on
+ */
+static ssize_t objectRead(CephFileRef &fr, ObjectReadRequest *req) {
+  bool async = !req->callers.empty();
+  XrdSysSemaphore waiter(0);
+  if (!async) req->waiter = &waiter;
+  librados::IoCtx *ioctx = selectIoCtx(fr, req->cephPoolIdx);
+  cephPoolOpStart(req->cephPoolIdx, req->nbBytes);
+  XrdCephBlockKey key = { fr.pool, fr.name, 0, 0 };
+  if (g_blockCache.enabled()) key.generation = blockCacheGeneration(fr);
+  std::vector<std::pair<librados::AioCompletion*, ObjectRead*> > waiting;
+  // the extra count is only dropped once all objects are submitted
+  req->pending = req->objects.size() + 1;
+  for (auto &it : req->objects) {
+    ObjectRead &obj = it.second;
+    if (g_blockCache.enabled()) {
+      key.objectNo = it.first;
+      std::shared_ptr<const ceph::bufferlist> cached = g_blockCache.get(key);
+      if (cached) {
+        for (auto &e : obj.extents) {
+          copyFromBlock(*cached, e.objectOffset, e.buf, e.len);
+        }
+        objectReadDone(req);
+        continue;
+      }
+    }
+    std::string oid = XrdCephStripeLayout::objectName(fr.name, it.first);
+    if (g_hedger.enabled()) {
+      int orc = hedgedObjectRead(ioctx, oid, obj);
+      if (orc < 0) {
+        completeObjectRead(&fr, obj, orc);
+        objectReadDone(req);
+      }
+      continue;
+    }
+    prepareObjectRead(obj);
+    librados::AioCompletion *completion = async ?
+      selectedCluster(fr, req->cephPoolIdx)->aio_create_completion(&obj, ceph_object_read_complete, NULL) :
+      librados::Rados::aio_create_completion();
+    int orc = ioctx->aio_operate(oid, completion, &obj.op, g_readFlags, 0);
+    if (orc < 0) {
+      completion->release();
+      completeObjectRead(&fr, obj, orc);
+      objectReadDone(req);
+    } else if (async) {
+      completion->release();
+    } else {
+      waiting.push_back(std::make_pair(completion, &obj));
+    }
+  }
+  if (async) {
+    objectReadDone(req);
+    return 0;
+  }
+  for (auto &w : waiting) {
+    w.first->wait_for_complete();
+    int orc = w.first->get_return_value();
+    w.first->release();
+    completeObjectRead(&fr, *w.second, orc);
+    objectReadDone(req);
+  }
+  // hedged reads complete through their callbacks
+  objectReadDone(req);
+  waiter.Wait();
+  cephPoolOpEnd(req->cephPoolIdx, req->nbBytes);
+  int rc = req->rc;
+  return rc < 0 ? rc : (ssize_t)req->nbBytes;
+}
+
+/**
+ * Serves a synchronous read directly from the objects of a file open for read
+ * when its layout and size were loaded at open. Returns false if the read has
+ * to go through the striper, in which case rc is not set. Otherwise rc is the
+ * number of bytes read or a negative errno
+ */
+static bool directRead(CephFileRef &fr, char *buf, size_t count, uint64_t offset, ssize_t &rc) {
+  if (!fr.directReads) return false;
+  uint64_t fileSize = fr.size;
+  if (offset >= fileSize || 0 == count) {
+    rc = 0;
+    return true;
+  }
+  ObjectReadRequest req(&fr);
+  addObjectReads(fr.stripeLayout, req, buf, offset, std::min((uint64_t)count, fileSize - offset));
+  rc = objectRead(fr, &req);
+  return true;
+}
+
+/// submits the batch of coalesced aio reads of a file, if any
+static void flushAioCoalesce(CephFileRef &fr) {
+  ObjectReadRequest *batch;
+  {
+    XrdSysMutexHelper lock(fr.aioCoalesce.mutex);
+    batch = fr.aioCoalesce.batch;
+    fr.aioCoalesce.batch = 0;
+  }
+  if (batch) {
+    g_aioCoalesceOps++;
+    objectRead(fr, batch);
+  }
+}
+
+/// body of the thread submitting the batches of coalesced aio reads once
+/// their window has elapsed
+static void aioCoalesceFlusher() {
+  g_aioCoalesceCond.Lock();
+  // when stopping, what is left is flushed right away
+  while (!g_aioCoalesceStop || !g_aioCoalesceQueue.empty()) {
+    if (g_aioCoalesceQueue.empty()) {
+      g_aioCoalesceCond.Wait();
+      continue;
+    }
+    std::pair<std::chrono::steady_clock::time_point, int> entry = g_aioCoalesceQueue.front();
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (entry.first > now && !g_aioCoalesceStop) {
+      // entries are queued in deadline order
+      g_aioCoalesceCond.UnLock();
+      std::this_thread::sleep_for(entry.first - now);
+      g_aioCoalesceCond.Lock();
+      continue;
+    }
+    g_aioCoalesceQueue.pop_front();
+    // the file was not closed as its entry was still queued, and close
+    // waits for g_aioCoalesceFlushing before freeing it
+    CephFileRef *fr = getFileRef(entry.second);
+    if (0 == fr) continue;
+    g_aioCoalesceFlushing = entry.second;
+    g_aioCoalesceCond.UnLock();
+    flushAioCoalesce(*fr);
+    g_aioCoalesceCond.Lock();
+    g_aioCoalesceFlushing = -1;
+    g_aioCoalesceCond.Broadcast();
+  }
+  g_aioCoalesceCond.UnLock();
+}
+
+/// schedules the submission of the batch of a file at the end of the window
+static void scheduleAioCoalesce(int fd) {
+  g_aioCoalesceCond.Lock();
+  if (0 == g_aioCoalesceThread) {
+    g_aioCoalesceThread = new std::thread(aioCoalesceFlusher);
+  }
+  g_aioCoalesceQueue.push_back(std::make_pair(std::chrono::steady_clock::now() +
+                                              std::chrono::microseconds(g_aioCoalesceWindow), fd));
+  g_aioCoalesceCond.Broadcast();
+  g_aioCoalesceCond.UnLock();
+}
+
+/// removes the scheduled submissions of a file being closed, and waits for
+/// the one in progress if any. The flusher does not use the file afterwards
+static void unscheduleAioCoalesce(int fd) {
+  if (0 == g_aioCoalesceWindow) return;
+  g_aioCoalesceCond.Lock();
+  for (auto it = g_aioCoalesceQueue.begin(); it != g_aioCoalesceQueue.end(); ) {
+    if (it->second == fd) {
+      it = g_aioCoalesceQueue.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  while (g_aioCoalesceFlushing == fd) g_aioCoalesceCond.Wait();
+  g_aioCoalesceCond.UnLock();
+}
+
+/// stops the flusher thread, submitting all pending batches
+static void stopAioCoalesce() {
+  g_aioCoalesceCond.Lock();
+  std::thread *flusher = g_aioCoalesceThread;
+  g_aioCoalesceThread = 0;
+  g_aioCoalesceStop = true;
+  g_aioCoalesceCond.Broadcast();
+  g_aioCoalesceCond.UnLock();
+  if (flusher) {
+    flusher->join();
+    delete flusher;
+  }
+  g_aioCoalesceStop = false;
+}
+
+/**
+ * queues an aio read of a file read directly from its objects in the batch
+ * of the file. Reads starting at most ceph.aiocoalesce gap bytes after the
+ * end of the previous one join its batch, so that reads of the same object
+ * end up in a single operation, and each caller is completed separately.
+ * Other reads submit the current batch and start a new one. Batches are
+ * submitted by a flusher thread at the end of the window.
+ */
+static int coalesceAioRead(CephFileRef &fr, int fd, XrdSfsAio *aiop, AioCB *cb,
+                           uint64_t offset, uint64_t len) {
+  ObjectReadRequest *previous = 0;
+  bool newBatch = false;
+  {
+    XrdSysMutexHelper lock(fr.aioCoalesce.mutex);
+    ObjectReadRequest *batch = fr.aioCoalesce.batch;
+    if (batch && (offset < fr.aioCoalesce.end ||
+                  offset > fr.aioCoalesce.end + g_aioCoalesceGap ||
+                  batch->nbBytes + len > g_aioCoalesceMaxBytes)) {
+      previous = batch;
+      batch = 0;
+    }
+    if (0 == batch) {
+      batch = new ObjectReadRequest(&fr, fd);
+      fr.aioCoalesce.batch = batch;
+      newBatch = true;
+    }
+    ObjectReadCaller caller = { aiop, cb, len };
+    batch->callers.push_back(caller);
+    addObjectReads(fr.stripeLayout, *batch, (char*)aiop->sfsAio.aio_buf, offset, len);
+    fr.aioCoalesce.end = offset + len;
+  }
+  g_aioCoalesceRequests++;
+  if (previous) {
+    g_aioCoalesceOps++;
+    objectRead(fr, previous);
+  }
+  if (newBatch) scheduleAioCoalesce(fd);
+  return 0;
+}
+
 ssize_t ceph_posix_read(int fd, void *buf, size_t count) {
   CephFileRef* fr = getFileRef(fd);
   if (fr) {
@@ -901,15 +3484,24 @@ ssize_t ceph_posix_read(int fd, void *buf, size_t count) {
     if ((fr->flags & O_WRONLY) != 0) {
       return -EBADF;
     }
-    libradosstriper::RadosStriper *striper = getRadosStriper(*fr);
-    if (0 == striper) {
-      return -EINVAL;
+    ssize_t rarc;
+    if (prefetchRead(*fr, (char*)buf, count, fr->offset, true, rarc) ||
+        readAheadRead(*fr, (char*)buf, count, fr->offset, true, rarc) ||
+        blockCacheRead(*fr, (char*)buf, count, fr->offset, true, rarc) ||
+        directRead(*fr, (char*)buf, count, fr->offset, rarc)) {
+      if (rarc > 0) fr->offset += rarc;
+      fr->rdcount++;
+      return rarc;
     }
     ceph::bufferlist bl;
+    wrapBuffer(bl, (char*)buf, count);
+    unsigned int cephPoolIdx;
+    libradosstriper::RadosStriper *striper = selectStriper(*fr, cephPoolIdx);
+    cephPoolOpStart(cephPoolIdx, count);
     int rc = striper->read(fr->name, &bl, count, fr->offset);
+    cephPoolOpEnd(cephPoolIdx, count);
     if (rc < 0) return rc;
-    bl.begin().copy(rc, (char*)buf);
-    XrdSysMutexHelper lock(fr->statsMutex);
+    completeReadBuffer(fr, bl, (char*)buf, rc);
     fr->offset += rc;
     fr->rdcount++;
     return rc;
@@ -926,15 +3518,23 @@ ssize_t ceph_posix_pread(int fd, void *buf, size_t count, off64_t offset) {
     if ((fr->flags & O_WRONLY) != 0) {
       return -EBADF;
     }
-    libradosstriper::RadosStriper *striper = getRadosStriper(*fr);
-    if (0 == striper) {
-      return -EINVAL;
+    ssize_t rarc;
+    if (prefetchRead(*fr, (char*)buf, count, offset, true, rarc) ||
+        readAheadRead(*fr, (char*)buf, count, offset, true, rarc) ||
+        blockCacheRead(*fr, (char*)buf, count, offset, true, rarc) ||
+        directRead(*fr, (char*)buf, count, offset, rarc)) {
+      fr->rdcount++;
+      return rarc;
     }
     ceph::bufferlist bl;
+    wrapBuffer(bl, (char*)buf, count);
+    unsigned int cephPoolIdx;
+    libradosstriper::RadosStriper *striper = selectStriper(*fr, cephPoolIdx);
+    cephPoolOpStart(cephPoolIdx, count);
     int rc = striper->read(fr->name, &bl, count, offset);
+    cephPoolOpEnd(cephPoolIdx, count);
     if (rc < 0) return rc;
-    bl.begin().copy(rc, (char*)buf);
-    XrdSysMutexHelper lock(fr->statsMutex);
+    completeReadBuffer(fr, bl, (char*)buf, rc);
     fr->rdcount++;
     return rc;
   } else {
@@ -942,21 +3542,65 @@ ssize_t ceph_posix_pread(int fd, void *buf, size_t count, off64_t offset) {
   }
 }
 
+/**
+ * read with computation of the CRC32C of each page, pages being aligned on
+ * file offsets. Files read directly from their objects are read as usual,
+ * the data landing in buf, and then checksummed in one pass. Other files
+ * are read through the striper into librados' buffers, the copy to buf and
+ * the checksums being done in a single pass over the data.
+ * csvec must have room for XrdOucPgrwUtils::csNum(offset, count) entries
+ */
+ssize_t ceph_posix_pgread(int fd, void *buf, size_t count, off64_t offset, uint32_t *csvec) {
+  CephFileRef* fr = getFileRef(fd);
+  if (fr) {
+    if ((fr->flags & O_WRONLY) != 0) {
+      return -EBADF;
+    }
+    if (0 == csvec || fr->directReads) {
+      ssize_t rc = ceph_posix_pread(fd, buf, count, offset);
+      if (rc > 0 && csvec) XrdOucPgrwUtils::csCalc((const char*)buf, offset, rc, csvec);
+      return rc;
+    }
+    ceph::bufferlist bl;
+    unsigned int cephPoolIdx;
+    libradosstriper::RadosStriper *striper = selectStriper(*fr, cephPoolIdx);
+    cephPoolOpStart(cephPoolIdx, count);
+    int rc = striper->read(fr->name, &bl, count, offset);
+    cephPoolOpEnd(cephPoolIdx, count);
+    if (rc < 0) return rc;
+    XrdCephPageCrc pageCrc(offset, csvec);
+    char *dest = (char*)buf;
+    size_t left = std::min((size_t)rc, (size_t)bl.length());
+    for (auto &bp : bl.buffers()) {
+      size_t n = std::min((size_t)bp.length(), left);
+      pageCrc.update(bp.c_str(), n, dest);
+      dest += n;
+      left -= n;
+      if (0 == left) break;
+    }
+    pageCrc.finish();
+    fr->rdcount++;
+    return dest - (char*)buf;
+  } else {
+    return -EBADF;
+  }
+}
+
 static void ceph_aio_read_complete(rados_completion_t c, void *arg) {
   AioArgs *awa = reinterpret_cast<AioArgs*>(arg);
   size_t rc = rados_aio_get_return_value(c);
+  cephPoolOpEnd(awa->cephPoolIdx, awa->nbBytes);
+  // Compute statistics before reportng to xrootd, so that a close cannot happen
+  // in the meantime.
+  CephFileRef* fr = getFileRef(awa->fd);
   if (awa->bl) {
-    if (rc > 0) {
-      awa->bl->begin().copy(rc, (char*)awa->aiop->sfsAio.aio_buf);
+    if ((ssize_t)rc > 0) {
+      completeReadBuffer(fr, *awa->bl, (char*)awa->aiop->sfsAio.aio_buf, rc);
     }
     delete awa->bl;
     awa->bl = 0;
   }
-  // Compute statistics before reportng to xrootd, so that a close cannot happen
-  // in the meantime.
-  CephFileRef* fr = getFileRef(awa->fd);
   if (fr) {
-    XrdSysMutexHelper lock(fr->statsMutex);
     fr->asyncRdCompletionCount++;
   }
   awa->callback(awa->aiop, rc );
@@ -974,28 +3618,50 @@ ssize_t ceph_aio_read(int fd, XrdSfsAio *aiop, AioCB *cb) {
     if ((fr->flags & O_WRONLY) != 0) {
       return -EBADF;
     }
-    // get the striper object
-    libradosstriper::RadosStriper *striper = getRadosStriper(*fr);
-    if (0 == striper) {
-      return -EINVAL;
+    // data already prefetched or cached is served inline
+    ssize_t rarc;
+    if (prefetchRead(*fr, (char*)aiop->sfsAio.aio_buf, count, offset, false, rarc) ||
+        readAheadRead(*fr, (char*)aiop->sfsAio.aio_buf, count, offset, false, rarc) ||
+        blockCacheRead(*fr, (char*)aiop->sfsAio.aio_buf, count, offset, false, rarc)) {
+      fr->asyncRdStartCount++;
+      fr->asyncRdCompletionCount++;
+      cb(aiop, rarc);
+      return 0;
     }
-    // prepare a bufferlist to receive data
-    ceph::bufferlist *bl = new ceph::bufferlist();
-    // get the poolIdx to use
-    int cephPoolIdx = getCephPoolIdxAndIncrease();
-    // Get the cluster to use
-    librados::Rados* cluster = checkAndCreateCluster(cephPoolIdx);
-    if (0 == cluster) {
-      return -EINVAL;
+    if (fr->directReads) {
+      uint64_t fileSize = fr->size;
+      fr->asyncRdStartCount++;
+      if (offset >= fileSize || 0 == count) {
+        fr->asyncRdCompletionCount++;
+        cb(aiop, 0);
+        return 0;
+      }
+      uint64_t len = std::min((uint64_t)count, fileSize - offset);
+      if (g_aioCoalesceWindow) {
+        return coalesceAioRead(*fr, fd, aiop, cb, offset, len);
+      }
+      ObjectReadRequest *req = new ObjectReadRequest(fr, fd);
+      ObjectReadCaller caller = { aiop, cb, len };
+      req->callers.push_back(caller);
+      addObjectReads(fr->stripeLayout, *req, (char*)aiop->sfsAio.aio_buf, offset, len);
+      return objectRead(*fr, req);
     }
+    // prepare a bufferlist to receive data directly in the xrootd buffer,
+    // which stays valid until the callback is called
+    ceph::bufferlist *bl = new ceph::bufferlist();
+    wrapBuffer(*bl, (char*)aiop->sfsAio.aio_buf, count);
+    // select the pool entry to use
+    unsigned int cephPoolIdx;
+    libradosstriper::RadosStriper *striper = selectStriper(*fr, cephPoolIdx);
     // prepare a ceph AioCompletion object and do async call
-    AioArgs *args = new AioArgs(aiop, cb, count, fd, bl);
+    AioArgs *args = new AioArgs(aiop, cb, count, fd, cephPoolIdx, bl);
     librados::AioCompletion *completion =
-      cluster->aio_create_completion(args, ceph_aio_read_complete, NULL);
+      selectedCluster(*fr, cephPoolIdx)->aio_create_completion(args, ceph_aio_read_complete, NULL);
     // do the read
+    cephPoolOpStart(cephPoolIdx, count);
     int rc = striper->aio_read(fr->name, completion, bl, count, offset);
     completion->release();
-    XrdSysMutexHelper lock(fr->statsMutex);
+    if (rc < 0) cephPoolOpEnd(cephPoolIdx, count);
     fr->asyncRdStartCount++;
     return rc;
   } else {
@@ -1003,6 +3669,50 @@ ssize_t ceph_aio_read(int fd, XrdSfsAio *aiop, AioCB *cb) {
   }
 }
 
+/**
+ * vector read, the chunks being read with one operation per underlying
+ * RADOS object, all objects being read in parallel.
+ * Holes (missing objects or objects shorter than their extent) are zero
+ * filled. Chunks going beyond the end of the file give -ESPIPE, like the
+ * default XrdOssDF::ReadV does for short reads.
+ * Files open for write are read chunk by chunk through the striper, as
+ * their objects are being modified and their size may not be known
+ * Returns the total number of bytes read or a negative errno
+ */
+ssize_t ceph_posix_readv(int fd, XrdOucIOVec *readV, int n) {
+  CephFileRef* fr = getFileRef(fd);
+  if (0 == fr) return -EBADF;
+  if ((fr->flags & O_WRONLY) != 0) {
+    return -EBADF;
+  }
+  ssize_t totalBytes = 0;
+  if ((fr->flags & O_ACCMODE) != O_RDONLY || !fr->statCached) {
+    for (int i = 0; i < n; i++) {
+      ssize_t rc = ceph_posix_pread(fd, readV[i].data, readV[i].size, readV[i].offset);
+      if (rc != readV[i].size) return rc < 0 ? rc : -ESPIPE;
+      totalBytes += rc;
+    }
+    return totalBytes;
+  }
+  XrdCephStripeLayout layout;
+  int rc = getStripeLayout(*fr, layout);
+  if (rc < 0) return rc;
+  uint64_t fileSize = fr->size;
+  ObjectReadRequest req(fr);
+  for (int i = 0; i < n; i++) {
+    if (readV[i].offset < 0 || readV[i].size < 0 ||
+        (uint64_t)readV[i].offset + readV[i].size > fileSize) {
+      return -ESPIPE;
+    }
+    addObjectReads(layout, req, readV[i].data, readV[i].offset, readV[i].size);
+    totalBytes += readV[i].size;
+  }
+  ssize_t rrc = objectRead(*fr, &req);
+  if (rrc < 0) return rrc;
+  fr->rdcount++;
+  return totalBytes;
+}
+
 int ceph_posix_fstat(int fd, struct stat *buf) {
   CephFileRef* fr = getFileRef(fd);
   if (fr) {
@@ -1010,15 +3720,21 @@ int ceph_posix_fstat(int fd, struct stat *buf) {
     // minimal stat : only size and times are filled
     // atime, mtime and ctime are set all to the same value
     // mode is set arbitrarily to 0666 | S_IFREG
-    libradosstriper::RadosStriper *striper = getRadosStriper(*fr);
-    if (0 == striper) {
-      logwrapper((char*)"ceph_stat: getRadosStriper failed");
-      return -EINVAL;
-    }
     memset(buf, 0, sizeof(*buf));
-    int rc = striper->stat(fr->name, (uint64_t*)&(buf->st_size), &(buf->st_atime));
-    if (rc != 0) {
-      return -rc;
+    bool forWrite = (fr->flags & (O_WRONLY|O_RDWR)) != 0;
+    if (fr->statCached && (!forWrite || CephFstatLocal == g_fstatMode)) {
+      // no need to go to the cluster, we know the answer
+      buf->st_size = fr->size;
+      buf->st_atime = fr->mtime;
+    } else {
+      int rc = fr->striper->stat(fr->name, (uint64_t*)&(buf->st_size), &(buf->st_atime));
+      if (rc != 0) {
+        return -rc;
+      }
+      // refresh our local knowledge
+      fr->size = buf->st_size;
+      fr->mtime = buf->st_atime;
+      fr->statCached = true;
     }
     buf->st_dev = 1;
     buf->st_ino = 1;
@@ -1066,9 +3782,28 @@ int ceph_posix_stat(XrdOucEnv* env, const char *pathname, struct stat *buf) {
 int ceph_posix_fsync(int fd) {
   CephFileRef* fr = getFileRef(fd);
   if (fr) {
-    // no locking of fr as it is not used.
     logwrapper((char*)"ceph_sync: fd %d", fd);
-    return 0;
+    // buffered writes are flushed, and all async writes are waited for,
+    // both within the same optional timeout
+    DrainDeadline deadline;
+    if (g_fsyncTimeout) {
+      deadline = std::chrono::steady_clock::now() + std::chrono::seconds(g_fsyncTimeout);
+    }
+    int rc = drainWriteBehind(*fr, fd, deadline);
+    if (-ETIMEDOUT == rc) return rc;
+    int aiorc = drainAioWrites(*fr, deadline);
+    return rc ? rc : aiorc;
+  } else {
+    return -EBADF;
+  }
+}
+
+/// size of the beginning of a file known to be written, i.e. such that all
+/// writes to it completed successfully. Does not wait for pending writes
+long long ceph_posix_committed_prefix(int fd) {
+  CephFileRef* fr = getFileRef(fd);
+  if (fr) {
+    return fr->committed.prefix();
   } else {
     return -EBADF;
   }
@@ -1247,7 +3982,11 @@ int ceph_posix_statfs(long long *totalSpace, long long *freeSpace) {
   // get the poolIdx to use
   int cephPoolIdx = getCephPoolIdxAndIncrease();
   // Get the cluster to use
-  librados::Rados* cluster = checkAndCreateCluster(cephPoolIdx);
+  librados::Rados* cluster;
+  {
+    XrdSysMutexHelper lock(g_layoutDicts[cephPoolIdx]->mutex());
+    cluster = checkAndCreateCluster(cephPoolIdx);
+  }
   if (0 == cluster) {
     return -EINVAL;
   }
@@ -1266,6 +4005,7 @@ static int ceph_posix_internal_truncate(const CephFile &file, unsigned long long
   if (0 == striper) {
     return -EINVAL;
   }
+  invalidateBlockCache(file);
   return striper->trunc(file.name, size);
 }
 
@@ -1273,7 +4013,18 @@ int ceph_posix_ftruncate(int fd, unsigned long long size) {
   CephFileRef* fr = getFileRef(fd);
   if (fr) {
     logwrapper((char*)"ceph_posix_ftruncate: fd %d, size %d", fd, size);
-    return ceph_posix_internal_truncate(*fr, size);
+    // pending writes must not land after the truncation
+    int rc = drainWriteBehind(*fr, fd);
+    if (0 == rc) rc = drainAioWrites(*fr);
+    if (rc) return rc;
+    rc = ceph_posix_internal_truncate(*fr, size);
+    invalidateChecksum(*fr);
+    if (0 == rc) {
+      fr->size = size;
+      fr->mtime = time(NULL);
+      fr->committed.truncate(size);
+    }
+    return rc;
   } else {
     return -EBADF;
   }
@@ -1294,6 +4045,7 @@ int ceph_posix_unlink(XrdOucEnv* env, const char *pathname) {
   if (0 == striper) {
     return -EINVAL;
   }
+  invalidateBlockCache(file);
   int rc = striper->remove(file.name);
   if (rc != -EBUSY) {
     return rc; 
@@ -31,14 +31,34 @@
 
 #include <sys/types.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <dirent.h>
+#include <string>
+#include <vector>
 #include <XrdOuc/XrdOucEnv.hh>
 #include <XrdSys/XrdSysXAttr.hh>
 
 class XrdSfsAio;
+struct XrdOucIOVec;
 typedef void(AioCB)(XrdSfsAio*, size_t);
 
 void ceph_posix_set_defaults(const char* value);
+int ceph_posix_set_pool_policy(const char *policy);
+int ceph_posix_set_fstat_mode(const char *mode);
+void ceph_posix_set_block_cache(unsigned long long capacity);
+int ceph_posix_set_read_mode(const char *mode);
+int ceph_posix_set_aio_write_limits(unsigned long long fileMaxBytes, unsigned int fileMaxOps,
+                                    unsigned long long maxBytes, unsigned int maxOps,
+                                    const char *overflow);
+int ceph_posix_set_streaming_checksum(const char *algorithm);
+int ceph_posix_set_write_behind(const char *chunk, unsigned long long capacity,
+                                const char *overflow);
+int ceph_posix_add_layout_rule(const char *prefix, const char *sizes, const char *layout);
+int ceph_posix_add_open_prefetch(const char *prefix, const char *head, const char *tail);
+void ceph_posix_set_hedged_reads(double percentile, unsigned long long minDelayUs,
+                                 unsigned long long maxDelayUs);
+int ceph_posix_warmup(const std::vector<std::string> &layouts);
+void ceph_posix_report_pool_load();
 void ceph_posix_disconnect_all();
 void ceph_posix_set_logfunc(void (*logfunc) (char *, va_list argp));
 int ceph_posix_open(XrdOucEnv* env, const char *pathname, int flags, mode_t mode);
@@ -50,10 +70,13 @@ ssize_t ceph_posix_pwrite(int fd, const void *buf, size_t count, off64_t offset)
 ssize_t ceph_aio_write(int fd, XrdSfsAio *aiop, AioCB *cb);
 ssize_t ceph_posix_read(int fd, void *buf, size_t count);
 ssize_t ceph_posix_pread(int fd, void *buf, size_t count, off64_t offset);
+ssize_t ceph_posix_readv(int fd, XrdOucIOVec *readV, int n);
+ssize_t ceph_posix_pgread(int fd, void *buf, size_t count, off64_t offset, uint32_t *csvec);
 ssize_t ceph_aio_read(int fd, XrdSfsAio *aiop, AioCB *cb);
 int ceph_posix_fstat(int fd, struct stat *buf);
 int ceph_posix_stat(XrdOucEnv* env, const char *pathname, struct stat *buf);
 int ceph_posix_fsync(int fd);
+long long ceph_posix_committed_prefix(int fd);
 int ceph_posix_fcntl(int fd, int cmd, ... /* arg */ );
 ssize_t ceph_posix_getxattr(XrdOucEnv* env, const char* path, const char* name,
                             void* value, size_t size);
@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// This file is part of the XRootD software suite.
+//
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//
+// In applying this licence, CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//------------------------------------------------------------------------------
+
+#ifndef __XRD_CEPH_STRIPE_LAYOUT_HH__
+#define __XRD_CEPH_STRIPE_LAYOUT_HH__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+//------------------------------------------------------------------------------
+//! Mapping of a striped file onto its underlying RADOS objects.
+//!
+//! This reproduces the layout used by libradosstriper : the file is cut into
+//! stripe units distributed round robin over stripeCount objects, until these
+//! objects reach objectSize, at which point a new set of stripeCount objects
+//! is started. Objects are named <file name>.<object number as %016x>.
+//------------------------------------------------------------------------------
+
+struct XrdCephStripeLayout {
+
+  XrdCephStripeLayout() : stripeUnit(0), stripeCount(0), objectSize(0) {}
+
+  XrdCephStripeLayout(uint64_t su, uint64_t sc, uint64_t os) :
+    stripeUnit(su), stripeCount(sc), objectSize(os) {}
+
+  /// whether the layout is usable for mapping offsets
+  bool valid() const {
+    return stripeUnit > 0 && stripeCount > 0 &&
+      objectSize >= stripeUnit && 0 == objectSize % stripeUnit;
+  }
+
+  /// name of the given object of the given file
+  static std::string objectName(const std::string &fileName, uint64_t objectNo) {
+    char suffix[18];
+    snprintf(suffix, sizeof(suffix), ".%016llx", (unsigned long long)objectNo);
+    return fileName + suffix;
+  }
+
+  /// calls f(objectNo, objectOffset, fileOffset, length) for each contiguous
+  /// piece of [offset, offset+length[ inside a single stripe unit of an object,
+  /// in increasing file offset order. The layout must be valid
+  template <typename F>
+  void map(uint64_t offset, uint64_t length, F f) const {
+    uint64_t stripesPerObject = objectSize / stripeUnit;
+    while (length > 0) {
+      uint64_t blockNo = offset / stripeUnit;
+      uint64_t stripeNo = blockNo / stripeCount;
+      uint64_t stripePos = blockNo % stripeCount;
+      uint64_t objectSetNo = stripeNo / stripesPerObject;
+      uint64_t objectNo = objectSetNo * stripeCount + stripePos;
+      uint64_t blockOffset = offset % stripeUnit;
+      uint64_t objectOffset = (stripeNo % stripesPerObject) * stripeUnit + blockOffset;
+      uint64_t len = stripeUnit - blockOffset;
+      if (len > length) len = length;
+      f(objectNo, objectOffset, offset, len);
+      offset += len;
+      length -= len;
+    }
+  }
+
+  uint64_t stripeUnit;
+  uint64_t stripeCount;
+  uint64_t objectSize;
+
+};
+
+#endif /* __XRD_CEPH_STRIPE_LAYOUT_HH__ */
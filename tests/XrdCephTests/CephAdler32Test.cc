@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//------------------------------------------------------------------------------
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <XrdCeph/XrdCephAdler32.hh>
+#include <cstdlib>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Declaration
+//------------------------------------------------------------------------------
+class CephAdler32Test: public CppUnit::TestCase
+{
+  public:
+    CPPUNIT_TEST_SUITE( CephAdler32Test );
+      CPPUNIT_TEST( KnownValueTest );
+      CPPUNIT_TEST( ConsistencyTest );
+      CPPUNIT_TEST( CombineTest );
+    CPPUNIT_TEST_SUITE_END();
+    void KnownValueTest();
+    void ConsistencyTest();
+    void CombineTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CephAdler32Test );
+
+static std::vector<char> randomData(size_t len) {
+  std::vector<char> data(len);
+  srand(42);
+  for (size_t i = 0; i < len; i++) data[i] = rand();
+  return data;
+}
+
+//------------------------------------------------------------------------------
+// Known value test
+//------------------------------------------------------------------------------
+void CephAdler32Test::KnownValueTest() {
+  const char *check = "Wikipedia";
+  CPPUNIT_ASSERT(0x11e60398 == XrdCephAdler32::calcSw(check, 9));
+  CPPUNIT_ASSERT(0x11e60398 == XrdCephAdler32::calc(check, 9));
+  CPPUNIT_ASSERT(1 == XrdCephAdler32::calc(check, 0));
+  // chaining
+  CPPUNIT_ASSERT(0x11e60398 == XrdCephAdler32::calc(check + 4, 5, XrdCephAdler32::calc(check, 4)));
+}
+
+//------------------------------------------------------------------------------
+// Consistency test : the SIMD kernel agrees with the plain implementation,
+// for all alignments and lengths, and for data maximizing the sums
+//------------------------------------------------------------------------------
+void CephAdler32Test::ConsistencyTest() {
+  std::vector<char> data = randomData(20000);
+  for (size_t start = 0; start < 9; start++) {
+    for (size_t len = 0; start + len <= data.size(); len += 997) {
+      CPPUNIT_ASSERT(XrdCephAdler32::calcSw(&data[start], len) ==
+                     XrdCephAdler32::calc(&data[start], len));
+    }
+  }
+  std::vector<char> ff(100000, (char)0xff);
+  CPPUNIT_ASSERT(XrdCephAdler32::calcSw(&ff[0], ff.size()) ==
+                 XrdCephAdler32::calc(&ff[0], ff.size()));
+}
+
+//------------------------------------------------------------------------------
+// Combine test : adler32 of two parts combined equals the one of the whole
+//------------------------------------------------------------------------------
+void CephAdler32Test::CombineTest() {
+  std::vector<char> data = randomData(100000);
+  uint32_t whole = XrdCephAdler32::calc(&data[0], data.size());
+  for (size_t split = 0; split <= data.size(); split += 9973) {
+    uint32_t a1 = XrdCephAdler32::calc(&data[0], split);
+    uint32_t a2 = XrdCephAdler32::calc(&data[split], data.size() - split);
+    CPPUNIT_ASSERT(whole == XrdCephAdler32::combine(a1, a2, data.size() - split));
+  }
+}
@@ -0,0 +1,222 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Micro benchmarks of the XrdCeph building blocks. They are kept out of the
+// unit tests and built on demand only, e.g. make XrdCephBenchmarks.
+// Usage : XrdCephBenchmarks [name...], running all benchmarks by default
+//------------------------------------------------------------------------------
+
+#include <XrdCeph/XrdCephCrc32c.hh>
+#include <XrdCeph/XrdCephFdTable.hh>
+#include <XrdCeph/XrdCephLayoutTable.hh>
+#include <XrdSys/XrdSysPthread.hh>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// File descriptor table : lookup throughput from 1 to 64 threads, compared
+// to a single mutex protecting a std::map, as used before
+//------------------------------------------------------------------------------
+template <typename Lookup>
+static double measureLookups(unsigned int nbThreads, const std::vector<int> &fds,
+                             Lookup lookup) {
+  std::atomic<bool> stop(false);
+  std::atomic<unsigned long long> total(0);
+  std::vector<std::thread> threads;
+  for (unsigned int t = 0; t < nbThreads; t++) {
+    threads.push_back(std::thread([&, t]() {
+      unsigned long long count = 0;
+      unsigned int i = t;
+      while (!stop.load(std::memory_order_relaxed)) {
+        for (unsigned int n = 0; n < 1024; n++) {
+          if (lookup(fds[i % fds.size()])) count++;
+          i++;
+        }
+      }
+      total += count;
+    }));
+  }
+  auto start = std::chrono::steady_clock::now();
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  stop = true;
+  for (unsigned int t = 0; t < nbThreads; t++) threads[t].join();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return total / elapsed.count();
+}
+
+static void fdTableBenchmark() {
+  const unsigned int nbFiles = 4096;
+  std::vector<int> values(nbFiles);
+  XrdCephFdTable<int> table;
+  std::vector<int> fds;
+  XrdSysMutex mapMutex;
+  std::map<unsigned int, int*> fdMap;
+  for (unsigned int i = 0; i < nbFiles; i++) {
+    fds.push_back(table.insert(&values[i]));
+    fdMap[fds.back()] = &values[i];
+  }
+  printf("threads    table lookups/s      map lookups/s\n");
+  for (unsigned int nbThreads = 1; nbThreads <= 64; nbThreads *= 2) {
+    double tableRate = measureLookups(nbThreads, fds, [&](int fd) {
+        return table.get(fd) != 0;
+      });
+    double mapRate = measureLookups(nbThreads, fds, [&](int fd) {
+        XrdSysMutexHelper lock(mapMutex);
+        return fdMap.find(fd) != fdMap.end();
+      });
+    printf("%7u %18.0f %18.0f\n", nbThreads, tableRate, mapRate);
+  }
+}
+
+//------------------------------------------------------------------------------
+// Layout table : compares the former stringstream based key and std::map
+// with the interned key and the open addressing table
+//------------------------------------------------------------------------------
+struct BenchFile {
+  std::string pool;
+  std::string userId;
+  unsigned int nbStripes;
+  unsigned long long stripeUnit;
+  unsigned long long objectSize;
+};
+
+static void layoutTableBenchmark() {
+  const unsigned int nbLookups = 1000000;
+  std::vector<BenchFile> files;
+  for (unsigned int i = 0; i < 8; i++) {
+    std::stringstream ss;
+    ss << "pool" << i;
+    files.push_back((BenchFile){ss.str(), "admin", 1 + i % 2, 4 << 20, 4 << 20});
+  }
+  // former path
+  XrdSysMutex mutex;
+  std::map<std::string, int> oldDict;
+  unsigned long long oldSum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int i = 0; i < nbLookups; i++) {
+    const BenchFile &file = files[i % files.size()];
+    XrdSysMutexHelper lock(mutex);
+    std::stringstream ss;
+    ss << file.userId << '@' << file.pool << ',' << file.nbStripes << ','
+       << file.stripeUnit << ',' << file.objectSize;
+    std::string userAtPool = ss.str();
+    std::map<std::string, int>::iterator it = oldDict.find(userAtPool);
+    if (it == oldDict.end()) {
+      it = oldDict.insert(std::pair<std::string, int>(userAtPool, i)).first;
+    }
+    oldSum += it->second;
+  }
+  std::chrono::duration<double> oldTime = std::chrono::steady_clock::now() - start;
+  // new path
+  XrdCephStringInterner interner;
+  XrdCephLayoutTable<int> table;
+  unsigned long long newSum = 0;
+  start = std::chrono::steady_clock::now();
+  for (unsigned int i = 0; i < nbLookups; i++) {
+    const BenchFile &file = files[i % files.size()];
+    XrdCephLayoutKey key;
+    XrdCephLayoutKey::make(interner, file.userId, file.pool, file.nbStripes,
+                           file.stripeUnit, file.objectSize, key);
+    newSum += *table.findOrCreate(key, [&](int &v) { v = i; return true; });
+  }
+  std::chrono::duration<double> newTime = std::chrono::steady_clock::now() - start;
+  printf("stringstream+map %.1f ns/op, interned key+table %.1f ns/op\n",
+         1e9 * oldTime.count() / nbLookups, 1e9 * newTime.count() / nbLookups);
+  if (oldSum != newSum) printf("inconsistent lookups\n");
+}
+
+//------------------------------------------------------------------------------
+// Page checksums : fused copy and page checksums against a copy
+// followed by a checksum pass
+//------------------------------------------------------------------------------
+template <typename F>
+static double measureThroughput(size_t len, F f) {
+  unsigned int rounds = 0;
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed;
+  do {
+    for (unsigned int i = 0; i < 16; i++) f();
+    rounds += 16;
+    elapsed = std::chrono::steady_clock::now() - start;
+  } while (elapsed.count() < 0.2);
+  return rounds * (double)len / elapsed.count() / (1024 * 1024 * 1024);
+}
+
+static void crc32cBenchmark() {
+  const size_t len = 8 * 1024 * 1024;
+  std::vector<char> data(len, 'x');
+  std::vector<char> dest(len);
+  std::vector<uint32_t> csvec(XrdOucPgrwUtils::csNum(0, len));
+  double pages = measureThroughput(len, [&]() {
+      XrdOucPgrwUtils::csCalc(&data[0], 0, len, &csvec[0]);
+    });
+  double copyThenCrc = measureThroughput(len, [&]() {
+      memcpy(&dest[0], &data[0], len);
+      XrdOucPgrwUtils::csCalc(&dest[0], 0, len, &csvec[0]);
+    });
+  double fused = measureThroughput(len, [&]() {
+      XrdCephPageCrc pc(0, &csvec[0]);
+      pc.update(&data[0], len, &dest[0]);
+      pc.finish();
+    });
+  printf("page crc32c              %8.2f GB/s\n", pages);
+  printf("memcpy then page crc32c  %8.2f GB/s\n", copyThenCrc);
+  printf("fused copy + page crc32c %8.2f GB/s\n", fused);
+}
+
+//------------------------------------------------------------------------------
+// Main
+//------------------------------------------------------------------------------
+struct Benchmark {
+  const char *name;
+  void (*run)();
+};
+
+static const Benchmark g_benchmarks[] = {
+  {"fdtable", fdTableBenchmark},
+  {"layouttable", layoutTableBenchmark},
+  {"crc32c", crc32cBenchmark},
+};
+
+int main(int argc, char **argv) {
+  int rc = 0;
+  for (int i = 1; i < argc; i++) {
+    bool found = false;
+    for (const Benchmark &b : g_benchmarks) found |= !strcmp(b.name, argv[i]);
+    if (!found) {
+      fprintf(stderr, "unknown benchmark %s\n", argv[i]);
+      rc = 1;
+    }
+  }
+  if (rc) return rc;
+  for (const Benchmark &b : g_benchmarks) {
+    bool selected = argc == 1;
+    for (int i = 1; i < argc; i++) selected |= !strcmp(b.name, argv[i]);
+    if (!selected) continue;
+    printf("== %s\n", b.name);
+    b.run();
+  }
+  return 0;
+}
@@ -0,0 +1,157 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//------------------------------------------------------------------------------
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <XrdCeph/XrdCephBlockCache.hh>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+
+//------------------------------------------------------------------------------
+// Declaration
+//------------------------------------------------------------------------------
+class CephBlockCacheTest: public CppUnit::TestCase
+{
+  public:
+    CPPUNIT_TEST_SUITE( CephBlockCacheTest );
+      CPPUNIT_TEST( PromotionTest );
+      CPPUNIT_TEST( EvictionTest );
+      CPPUNIT_TEST( InvalidationTest );
+      CPPUNIT_TEST( EpochTest );
+    CPPUNIT_TEST_SUITE_END();
+    void PromotionTest();
+    void EvictionTest();
+    void InvalidationTest();
+    void EpochTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CephBlockCacheTest );
+
+typedef XrdCephBlockCache<std::string> Cache;
+
+static XrdCephBlockKey blockKey(uint64_t objectNo, uint64_t generation = 0) {
+  XrdCephBlockKey key = { "pool", "file", objectNo, generation };
+  return key;
+}
+
+static void put(Cache &cache, uint64_t objectNo, uint64_t generation = 0) {
+  cache.put(blockKey(objectNo, generation), std::make_shared<std::string>(100, 'a' + objectNo % 26), 100);
+}
+
+//------------------------------------------------------------------------------
+// Promotion test : blocks pushed out of A1in are only remembered as ghosts,
+// and enter the main queue when put again while remembered. A scan of new
+// blocks then leaves them alone
+//------------------------------------------------------------------------------
+void CephBlockCacheTest::PromotionTest() {
+  Cache cache;
+  CPPUNIT_ASSERT(!cache.enabled());
+  cache.setCapacity(400);
+  CPPUNIT_ASSERT(cache.enabled());
+  for (uint64_t i = 0; i < 5; i++) put(cache, i);
+  // block 0, the oldest of A1in, became a ghost
+  CPPUNIT_ASSERT(cache.usedBytes() == 400);
+  CPPUNIT_ASSERT(cache.evictions() == 1);
+  CPPUNIT_ASSERT(!cache.get(blockKey(0)));
+  std::shared_ptr<const std::string> b1 = cache.get(blockKey(1));
+  CPPUNIT_ASSERT(b1 && *b1 == std::string(100, 'b'));
+  CPPUNIT_ASSERT(cache.hits() == 1 && cache.misses() == 1);
+  // missed again while remembered, goes to the main queue
+  put(cache, 0);
+  for (uint64_t i = 10; i < 30; i++) put(cache, i);
+  CPPUNIT_ASSERT(cache.get(blockKey(0)));
+  CPPUNIT_ASSERT(cache.usedBytes() <= 400);
+  // the scan went through A1in only
+  CPPUNIT_ASSERT(!cache.get(blockKey(10)));
+  CPPUNIT_ASSERT(cache.get(blockKey(29)));
+}
+
+//------------------------------------------------------------------------------
+// Eviction test : the cache stays within its capacity in bytes
+//------------------------------------------------------------------------------
+void CephBlockCacheTest::EvictionTest() {
+  Cache cache;
+  cache.setCapacity(1000);
+  // blocks larger than the cache are not taken
+  cache.put(blockKey(0), std::make_shared<std::string>(2000, 'x'), 2000);
+  CPPUNIT_ASSERT(cache.usedBytes() == 0 && !cache.get(blockKey(0)));
+  for (uint64_t i = 1; i <= 100; i++) {
+    put(cache, i);
+    CPPUNIT_ASSERT(cache.usedBytes() <= 1000);
+  }
+  CPPUNIT_ASSERT(cache.usedBytes() == 1000);
+  CPPUNIT_ASSERT(cache.evictions() == 90);
+  // putting a cached block again changes nothing
+  put(cache, 100);
+  CPPUNIT_ASSERT(cache.usedBytes() == 1000 && cache.evictions() == 90);
+  // a block of the main queue is evicted once least recently used
+  put(cache, 1);
+  CPPUNIT_ASSERT(cache.get(blockKey(1)));
+  for (uint64_t i = 200; i < 220; i++) {
+    cache.put(blockKey(i), std::make_shared<std::string>(400, 'y'), 400);
+    cache.get(blockKey(i));
+    put(cache, i);
+  }
+  CPPUNIT_ASSERT(cache.usedBytes() <= 1000);
+}
+
+//------------------------------------------------------------------------------
+// Invalidation test : blocks of a former generation of a file are not found
+//------------------------------------------------------------------------------
+void CephBlockCacheTest::InvalidationTest() {
+  Cache cache;
+  cache.setCapacity(1000);
+  uint64_t gen = cache.generation("file");
+  put(cache, 1, gen);
+  CPPUNIT_ASSERT(cache.get(blockKey(1, gen)));
+  cache.invalidate("file");
+  CPPUNIT_ASSERT(cache.invalidations() == 1);
+  uint64_t newGen = cache.generation("file");
+  CPPUNIT_ASSERT(newGen != gen);
+  CPPUNIT_ASSERT(!cache.get(blockKey(1, newGen)));
+  // other files are not affected
+  CPPUNIT_ASSERT(cache.generation("other") == gen);
+}
+
+//------------------------------------------------------------------------------
+// Epoch test : when too many generations are remembered, all files move to
+// a new epoch, which is never a generation used before
+//------------------------------------------------------------------------------
+void CephBlockCacheTest::EpochTest() {
+  Cache cache;
+  cache.setCapacity(1000);
+  std::set<uint64_t> used;
+  used.insert(cache.generation("never"));
+  for (size_t i = 0; i < Cache::MaxGenerations; i++) {
+    std::stringstream ss;
+    ss << "file" << i;
+    cache.invalidate(ss.str());
+    used.insert(cache.generation(ss.str()));
+  }
+  CPPUNIT_ASSERT(used.size() == Cache::MaxGenerations + 1);
+  uint64_t file0 = cache.generation("file0");
+  // the next invalidation moves all files to a new epoch
+  cache.invalidate("last");
+  uint64_t epoch = cache.generation("file0");
+  CPPUNIT_ASSERT(epoch != file0);
+  CPPUNIT_ASSERT(used.count(epoch) == 0);
+  CPPUNIT_ASSERT(cache.generation("never") == epoch);
+  CPPUNIT_ASSERT(cache.generation("last") != epoch);
+  CPPUNIT_ASSERT(used.count(cache.generation("last")) == 0);
+  CPPUNIT_ASSERT(cache.invalidations() == Cache::MaxGenerations + 1);
+}
@@ -0,0 +1,120 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//------------------------------------------------------------------------------
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <XrdCeph/XrdCephCommittedRanges.hh>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Declaration
+//------------------------------------------------------------------------------
+class CephCommittedRangesTest: public CppUnit::TestCase
+{
+  public:
+    CPPUNIT_TEST_SUITE( CephCommittedRangesTest );
+      CPPUNIT_TEST( OrderTest );
+      CPPUNIT_TEST( TruncateTest );
+      CPPUNIT_TEST( ConcurrencyTest );
+    CPPUNIT_TEST_SUITE_END();
+    void OrderTest();
+    void TruncateTest();
+    void ConcurrencyTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CephCommittedRangesTest );
+
+//------------------------------------------------------------------------------
+// Order test : the prefix only grows once all writes before it completed,
+// whatever their order, overlaps and duplicates
+//------------------------------------------------------------------------------
+void CephCommittedRangesTest::OrderTest() {
+  XrdCephCommittedRanges cr;
+  CPPUNIT_ASSERT(cr.prefix() == 0);
+  cr.commit(0, 100);
+  CPPUNIT_ASSERT(cr.prefix() == 100 && cr.nbRanges() == 0);
+  cr.commit(300, 100);
+  cr.commit(150, 50);
+  CPPUNIT_ASSERT(cr.prefix() == 100 && cr.nbRanges() == 2);
+  // touching ranges are merged
+  cr.commit(200, 100);
+  CPPUNIT_ASSERT(cr.prefix() == 100 && cr.nbRanges() == 1);
+  // overlapping the prefix and the pending range
+  cr.commit(50, 120);
+  CPPUNIT_ASSERT(cr.prefix() == 400 && cr.nbRanges() == 0);
+  // rewrites inside the prefix change nothing
+  cr.commit(10, 10);
+  CPPUNIT_ASSERT(cr.prefix() == 400 && cr.nbRanges() == 0);
+  // empty writes neither
+  cr.commit(1000, 0);
+  CPPUNIT_ASSERT(cr.prefix() == 400 && cr.nbRanges() == 0);
+  cr.commit(400, 600);
+  CPPUNIT_ASSERT(cr.prefix() == 1000 && cr.nbRanges() == 0);
+}
+
+//------------------------------------------------------------------------------
+// Truncate test
+//------------------------------------------------------------------------------
+void CephCommittedRangesTest::TruncateTest() {
+  XrdCephCommittedRanges cr;
+  cr.commit(0, 100);
+  cr.commit(200, 100);
+  cr.commit(400, 100);
+  // cuts the range across the new size and drops the ones after
+  cr.truncate(250);
+  CPPUNIT_ASSERT(cr.prefix() == 100 && cr.nbRanges() == 1);
+  cr.commit(100, 100);
+  CPPUNIT_ASSERT(cr.prefix() == 250 && cr.nbRanges() == 0);
+  cr.truncate(50);
+  CPPUNIT_ASSERT(cr.prefix() == 50);
+  // growing the file does not commit anything
+  cr.truncate(1000);
+  CPPUNIT_ASSERT(cr.prefix() == 50 && cr.nbRanges() == 0);
+}
+
+//------------------------------------------------------------------------------
+// Concurrency test : chunks of a file committed in random order by several
+// threads end up in a single prefix covering the whole file
+//------------------------------------------------------------------------------
+void CephCommittedRangesTest::ConcurrencyTest() {
+  const unsigned int nbThreads = 8;
+  const unsigned int nbChunks = 10000;
+  const uint64_t chunkSize = 4096;
+  std::vector<unsigned int> chunks(nbChunks);
+  for (unsigned int i = 0; i < nbChunks; i++) chunks[i] = i;
+  std::mt19937 rng(42);
+  std::shuffle(chunks.begin(), chunks.end(), rng);
+  XrdCephCommittedRanges cr;
+  std::vector<std::thread> threads;
+  for (unsigned int t = 0; t < nbThreads; t++) {
+    threads.push_back(std::thread([&, t]() {
+      uint64_t last = 0;
+      for (unsigned int i = t; i < nbChunks; i += nbThreads) {
+        cr.commit(chunks[i] * chunkSize, chunkSize);
+        // the prefix never goes backwards
+        uint64_t prefix = cr.prefix();
+        CPPUNIT_ASSERT(prefix >= last);
+        last = prefix;
+      }
+    }));
+  }
+  for (auto &t : threads) t.join();
+  CPPUNIT_ASSERT(cr.prefix() == nbChunks * chunkSize);
+  CPPUNIT_ASSERT(cr.nbRanges() == 0);
+}
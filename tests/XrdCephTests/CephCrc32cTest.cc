@@ -0,0 +1,87 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//------------------------------------------------------------------------------
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <XrdCeph/XrdCephCrc32c.hh>
+#include <cstdlib>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Declaration
+//------------------------------------------------------------------------------
+class CephCrc32cTest: public CppUnit::TestCase
+{
+  public:
+    CPPUNIT_TEST_SUITE( CephCrc32cTest );
+      CPPUNIT_TEST( PagesTest );
+      CPPUNIT_TEST( CombineTest );
+    CPPUNIT_TEST_SUITE_END();
+    void PagesTest();
+    void CombineTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CephCrc32cTest );
+
+static std::vector<char> randomData(size_t len) {
+  std::vector<char> data(len);
+  srand(42);
+  for (size_t i = 0; i < len; i++) data[i] = rand();
+  return data;
+}
+
+//------------------------------------------------------------------------------
+// Pages test : page checksums of data given in irregular pieces, with and
+// without copy, against the ones of XrdOucPgrwUtils
+//------------------------------------------------------------------------------
+void CephCrc32cTest::PagesTest() {
+  const size_t ps = XrdOucPgrwUtils::pgPageSize;
+  std::vector<char> data = randomData(5 * ps);
+  off_t offset = ps - 100;
+  size_t len = 3 * ps + 200;
+  size_t nbPages = XrdOucPgrwUtils::csNum(offset, len);
+  CPPUNIT_ASSERT(5 == nbPages);
+  std::vector<uint32_t> csvec(nbPages);
+  XrdOucPgrwUtils::csCalc(&data[0], offset, len, &csvec[0]);
+  for (int withCopy = 0; withCopy < 2; withCopy++) {
+    std::vector<uint32_t> csvec2(nbPages);
+    std::vector<char> copy(len);
+    XrdCephPageCrc pc(offset, &csvec2[0]);
+    size_t done = 0, piece = 1;
+    while (done < len) {
+      size_t n = std::min(piece, len - done);
+      pc.update(&data[done], n, withCopy ? &copy[done] : 0);
+      done += n;
+      piece = piece * 3 + 1;
+    }
+    pc.finish();
+    CPPUNIT_ASSERT(csvec == csvec2);
+    if (withCopy) CPPUNIT_ASSERT(0 == memcmp(&copy[0], &data[0], len));
+  }
+}
+
+//------------------------------------------------------------------------------
+// Combine test : crc of two parts combined equals the crc of the whole
+//------------------------------------------------------------------------------
+void CephCrc32cTest::CombineTest() {
+  std::vector<char> data = randomData(100000);
+  uint32_t whole = XrdOucCRC::Calc32C(&data[0], data.size());
+  for (size_t split = 0; split <= data.size(); split += 9973) {
+    uint32_t crc1 = XrdOucCRC::Calc32C(&data[0], split);
+    uint32_t crc2 = XrdOucCRC::Calc32C(&data[split], data.size() - split);
+    CPPUNIT_ASSERT(whole == XrdCephCrc32c::combine(crc1, crc2, data.size() - split));
+  }
+}
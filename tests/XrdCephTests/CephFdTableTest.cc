@@ -0,0 +1,90 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//------------------------------------------------------------------------------
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <XrdCeph/XrdCephFdTable.hh>
+#include <map>
+#include <set>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Declaration
+//------------------------------------------------------------------------------
+class CephFdTableTest: public CppUnit::TestCase
+{
+  public:
+    CPPUNIT_TEST_SUITE( CephFdTableTest );
+      CPPUNIT_TEST( InsertRemoveTest );
+      CPPUNIT_TEST( GenerationTest );
+    CPPUNIT_TEST_SUITE_END();
+    void InsertRemoveTest();
+    void GenerationTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CephFdTableTest );
+
+typedef XrdCephFdTable<int> IntFdTable;
+
+//------------------------------------------------------------------------------
+// Insert/remove test
+//------------------------------------------------------------------------------
+void CephFdTableTest::InsertRemoveTest() {
+  IntFdTable table;
+  std::vector<int> values(1000);
+  std::map<int, int*> fds;
+  for (unsigned int i = 0; i < values.size(); i++) {
+    values[i] = i;
+    int fd = table.insert(&values[i]);
+    CPPUNIT_ASSERT(fd >= 0);
+    CPPUNIT_ASSERT(fds.find(fd) == fds.end());
+    fds[fd] = &values[i];
+  }
+  for (std::map<int, int*>::const_iterator it = fds.begin(); it != fds.end(); it++) {
+    CPPUNIT_ASSERT(table.get(it->first) == it->second);
+  }
+  for (std::map<int, int*>::const_iterator it = fds.begin(); it != fds.end(); it++) {
+    CPPUNIT_ASSERT(table.remove(it->first) == it->second);
+    CPPUNIT_ASSERT(table.get(it->first) == 0);
+    CPPUNIT_ASSERT(table.remove(it->first) == 0);
+  }
+  CPPUNIT_ASSERT(table.get(-1) == 0);
+  CPPUNIT_ASSERT(table.get(IntFdTable::MaxSlots - 1) == 0);
+}
+
+//------------------------------------------------------------------------------
+// Generation test : slots are reused, stale descriptors are rejected
+//------------------------------------------------------------------------------
+void CephFdTableTest::GenerationTest() {
+  IntFdTable table;
+  int a = 1, b = 2;
+  std::set<unsigned int> slots;
+  int fd = table.insert(&a);
+  slots.insert(fd & IntFdTable::IndexMask);
+  for (unsigned int i = 0; i < 10 * IntFdTable::NbShards; i++) {
+    CPPUNIT_ASSERT(table.remove(fd) == &a);
+    int newFd = table.insert(&b);
+    CPPUNIT_ASSERT(newFd >= 0);
+    CPPUNIT_ASSERT(newFd != fd);
+    CPPUNIT_ASSERT(table.get(fd) == 0);
+    CPPUNIT_ASSERT(table.get(newFd) == &b);
+    CPPUNIT_ASSERT(table.remove(newFd) == &b);
+    fd = table.insert(&a);
+    slots.insert(fd & IntFdTable::IndexMask);
+  }
+  // only one slot per shard should ever have been used
+  CPPUNIT_ASSERT(slots.size() <= IntFdTable::NbShards);
+}
@@ -0,0 +1,235 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//------------------------------------------------------------------------------
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <XrdCeph/XrdCephHedge.hh>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Declaration
+//------------------------------------------------------------------------------
+class CephHedgeTest: public CppUnit::TestCase
+{
+  public:
+    CPPUNIT_TEST_SUITE( CephHedgeTest );
+      CPPUNIT_TEST( HistogramTest );
+      CPPUNIT_TEST( LatencyInjectionTest );
+      CPPUNIT_TEST( FailureTest );
+    CPPUNIT_TEST_SUITE_END();
+    void HistogramTest();
+    void LatencyInjectionTest();
+    void FailureTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CephHedgeTest );
+
+//------------------------------------------------------------------------------
+// Histogram test
+//------------------------------------------------------------------------------
+void CephHedgeTest::HistogramTest() {
+  for (uint64_t us = 0; us < 100000; us += 7) {
+    unsigned int b = XrdCephLatencyHistogram::bucket(us);
+    CPPUNIT_ASSERT(us <= XrdCephLatencyHistogram::upperBound(b));
+    CPPUNIT_ASSERT(0 == b || us > XrdCephLatencyHistogram::upperBound(b - 1));
+  }
+  XrdCephLatencyHistogram h;
+  CPPUNIT_ASSERT(h.percentile(99) == 0);
+  for (unsigned int i = 0; i < 990; i++) h.record(1000);
+  for (unsigned int i = 0; i < 10; i++) h.record(50000);
+  CPPUNIT_ASSERT(h.count() == 1000);
+  uint64_t p50 = h.percentile(50);
+  CPPUNIT_ASSERT(p50 >= 1000 && p50 < 1200);
+  uint64_t p995 = h.percentile(99.5);
+  CPPUNIT_ASSERT(p995 >= 50000 && p995 < 60000);
+}
+
+//------------------------------------------------------------------------------
+// Simulated replicated backend, driven by a fake clock so that the outcome
+// does not depend on the load of the machine running the tests. Each read
+// is issued and the time advanced by small steps until it completes, the
+// hedger being polled at each step
+//------------------------------------------------------------------------------
+static XrdCephHedger::Clock::time_point g_fakeNow;
+
+static XrdCephHedger::Clock::time_point fakeNow() { return g_fakeNow; }
+
+/// latency in microseconds and success of an attempt
+struct SimOutcome {
+  uint64_t latency;
+  bool ok;
+};
+
+struct SimBackend;
+
+struct SimRead : XrdCephHedged {
+  SimRead(SimBackend &b, unsigned int i) : backend(b), index(i), finished(false), failed(false) {}
+  void hedge() override;
+  SimBackend &backend;
+  unsigned int index;
+  bool finished;
+  bool failed;
+  XrdCephHedger::Clock::time_point end;
+};
+
+struct SimBackend {
+  typedef std::function<SimOutcome(unsigned int index, bool isHedge)> Model;
+  SimBackend(XrdCephHedger &h, Model m) : hedger(h), model(m) {}
+  void issue(std::shared_ptr<SimRead> read, bool isHedge) {
+    SimOutcome o = model(read->index, isHedge);
+    XrdCephHedger::Clock::time_point start = g_fakeNow;
+    pending.insert(std::make_pair(g_fakeNow + std::chrono::microseconds(o.latency),
+                                  [this, read, isHedge, o, start]() {
+      if (!isHedge) {
+        hedger.record(std::chrono::duration_cast<std::chrono::microseconds>
+                      (g_fakeNow - start).count());
+      }
+      if (!read->finish(!o.ok)) return;
+      if (isHedge && o.ok) hedger.won();
+      read->finished = true;
+      read->failed = !o.ok;
+      read->end = g_fakeNow;
+    }));
+  }
+  /// advances the fake clock, completing the attempts due meanwhile
+  void step() {
+    g_fakeNow += std::chrono::microseconds(10);
+    while (!pending.empty() && pending.begin()->first <= g_fakeNow) {
+      std::function<void()> f = pending.begin()->second;
+      pending.erase(pending.begin());
+      f();
+    }
+    hedger.poll();
+  }
+  /// runs a read until it completes
+  std::shared_ptr<SimRead> read(unsigned int index, bool hedging) {
+    std::shared_ptr<SimRead> r = std::make_shared<SimRead>(*this, index);
+    issue(r, false);
+    if (hedging) hedger.watch(r);
+    while (!r->finished) step();
+    return r;
+  }
+  /// lets the losing attempts complete
+  void drain() {
+    while (!pending.empty()) step();
+  }
+  XrdCephHedger &hedger;
+  Model model;
+  std::multimap<XrdCephHedger::Clock::time_point, std::function<void()> > pending;
+};
+
+void SimRead::hedge() {
+  backend.issue(std::static_pointer_cast<SimRead>(shared_from_this()), true);
+}
+
+//------------------------------------------------------------------------------
+// Latency injection test : one read out of 50 is slow on its first attempt.
+// Exactly those get hedged, and their hedge wins
+//------------------------------------------------------------------------------
+static SimOutcome slowModel(unsigned int index, bool isHedge) {
+  SimOutcome o = { (!isHedge && 0 == index % 50) ? 30000u : 300u, true };
+  return o;
+}
+
+static uint64_t runReads(bool hedging, unsigned long long &issued, unsigned long long &won) {
+  const unsigned int nbReads = 750;
+  XrdCephHedger hedger(&fakeNow, false);
+  if (hedging) hedger.configure(95, 200, 5000);
+  SimBackend backend(hedger, slowModel);
+  uint64_t longest = 0;
+  for (unsigned int i = 0; i < nbReads; i++) {
+    XrdCephHedger::Clock::time_point start = g_fakeNow;
+    std::shared_ptr<SimRead> r = backend.read(i, hedging);
+    CPPUNIT_ASSERT(!r->failed);
+    uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(r->end - start).count();
+    longest = std::max(longest, us);
+  }
+  backend.drain();
+  issued = hedger.issued();
+  won = hedger.wins();
+  hedger.stop();
+  return longest;
+}
+
+void CephHedgeTest::LatencyInjectionTest() {
+  unsigned long long issued, won;
+  uint64_t plain = runReads(false, issued, won);
+  CPPUNIT_ASSERT(issued == 0 && won == 0);
+  CPPUNIT_ASSERT(plain >= 30000);
+  uint64_t hedged = runReads(true, issued, won);
+  printf("hedged reads : longest read without hedging %llu us, with hedging %llu us, "
+         "hedges issued %llu, won %llu\n", (unsigned long long)plain,
+         (unsigned long long)hedged, issued, won);
+  // 15 slow reads, hedged at the maximal delay until enough latencies are
+  // known, then at the 95th percentile of about 300us
+  CPPUNIT_ASSERT(issued == 15);
+  CPPUNIT_ASSERT(won == 15);
+  CPPUNIT_ASSERT(hedged <= 5000 + 300 + 10);
+}
+
+//------------------------------------------------------------------------------
+// Failure test : a first attempt failing while the hedge is in flight does
+// not complete the read, a read fails only when all its attempts did, and
+// a first attempt failing before its deadline is not hedged
+//------------------------------------------------------------------------------
+static SimOutcome failureModel(unsigned int index, bool isHedge) {
+  SimOutcome o = { 300, true };
+  switch (index) {
+    case 0:
+      // first attempt fails after the hedge was sent, the hedge succeeds
+      if (!isHedge) o = { 3000, false };
+      else o = { 5000, true };
+      break;
+    case 1:
+      // both attempts fail
+      if (!isHedge) o = { 3000, false };
+      else o = { 5000, false };
+      break;
+    case 2:
+      // the first attempt fails before the deadline
+      if (!isHedge) o = { 100, false };
+      break;
+  }
+  return o;
+}
+
+void CephHedgeTest::FailureTest() {
+  XrdCephHedger hedger(&fakeNow, false);
+  hedger.configure(95, 1000, 1000);
+  SimBackend backend(hedger, failureModel);
+  XrdCephHedger::Clock::time_point start = g_fakeNow;
+  std::shared_ptr<SimRead> r = backend.read(0, true);
+  CPPUNIT_ASSERT(!r->failed);
+  CPPUNIT_ASSERT(r->end - start >= std::chrono::microseconds(1000 + 5000));
+  CPPUNIT_ASSERT(hedger.issued() == 1 && hedger.wins() == 1);
+  start = g_fakeNow;
+  r = backend.read(1, true);
+  CPPUNIT_ASSERT(r->failed);
+  CPPUNIT_ASSERT(r->end - start >= std::chrono::microseconds(1000 + 5000));
+  CPPUNIT_ASSERT(hedger.issued() == 2 && hedger.wins() == 1);
+  start = g_fakeNow;
+  r = backend.read(2, true);
+  CPPUNIT_ASSERT(r->failed);
+  CPPUNIT_ASSERT(r->end - start < std::chrono::microseconds(1000));
+  backend.drain();
+  CPPUNIT_ASSERT(hedger.issued() == 2 && hedger.wins() == 1);
+  hedger.stop();
+}
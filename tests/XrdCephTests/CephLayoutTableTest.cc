@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//------------------------------------------------------------------------------
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <XrdCeph/XrdCephLayoutTable.hh>
+#include <sstream>
+#include <string>
+
+//------------------------------------------------------------------------------
+// Declaration
+//------------------------------------------------------------------------------
+class CephLayoutTableTest: public CppUnit::TestCase
+{
+  public:
+    CPPUNIT_TEST_SUITE( CephLayoutTableTest );
+      CPPUNIT_TEST( InternTest );
+      CPPUNIT_TEST( TableTest );
+    CPPUNIT_TEST_SUITE_END();
+    void InternTest();
+    void TableTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CephLayoutTableTest );
+
+#define MB 1024*1024
+
+//------------------------------------------------------------------------------
+// Intern test
+//------------------------------------------------------------------------------
+void CephLayoutTableTest::InternTest() {
+  XrdCephStringInterner interner;
+  unsigned int admin = interner.intern("admin");
+  unsigned int pool = interner.intern("pool");
+  CPPUNIT_ASSERT(admin != pool);
+  CPPUNIT_ASSERT(interner.intern(std::string("admin")) == admin);
+  CPPUNIT_ASSERT(interner.intern("pool") == pool);
+  CPPUNIT_ASSERT(interner.intern("") != admin);
+  for (unsigned int i = 0; i < XrdCephStringInterner::Capacity; i++) {
+    std::stringstream ss;
+    ss << "user" << i;
+    interner.intern(ss.str());
+  }
+  CPPUNIT_ASSERT(interner.intern("onemore") == XrdCephStringInterner::Invalid);
+  CPPUNIT_ASSERT(interner.intern("admin") == admin);
+}
+
+//------------------------------------------------------------------------------
+// Table test
+//------------------------------------------------------------------------------
+void CephLayoutTableTest::TableTest() {
+  XrdCephStringInterner interner;
+  XrdCephLayoutTable<int> table;
+  XrdCephLayoutKey k1, k2, k3;
+  CPPUNIT_ASSERT(XrdCephLayoutKey::make(interner, "admin", "pool", 1, 4*MB, 4*MB, k1));
+  CPPUNIT_ASSERT(XrdCephLayoutKey::make(interner, "admin", "pool", 2, 4*MB, 4*MB, k2));
+  CPPUNIT_ASSERT(XrdCephLayoutKey::make(interner, "pool", "admin", 1, 4*MB, 4*MB, k3));
+  CPPUNIT_ASSERT(!(k1 == k2));
+  CPPUNIT_ASSERT(!(k1 == k3));
+  CPPUNIT_ASSERT(table.find(k1) == 0);
+  unsigned int nbCreations = 0;
+  int *v1 = table.findOrCreate(k1, [&](int &v) { v = 1; nbCreations++; return true; });
+  CPPUNIT_ASSERT(v1 && *v1 == 1);
+  CPPUNIT_ASSERT(table.findOrCreate(k1, [&](int &v) { nbCreations++; return true; }) == v1);
+  CPPUNIT_ASSERT(nbCreations == 1);
+  CPPUNIT_ASSERT(table.findOrCreate(k2, [](int &v) { return false; }) == 0);
+  CPPUNIT_ASSERT(table.find(k2) == 0);
+  int *v3 = table.findOrCreate(k3, [](int &v) { v = 3; return true; });
+  CPPUNIT_ASSERT(v3 && *v3 == 3 && table.find(k3) == v3 && table.find(k1) == v1);
+  int sum = 0;
+  table.forEach([&](int &v) { sum += v; });
+  CPPUNIT_ASSERT(sum == 4);
+  table.clear();
+  CPPUNIT_ASSERT(table.find(k1) == 0);
+}
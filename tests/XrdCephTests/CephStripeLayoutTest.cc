@@ -0,0 +1,132 @@
+//------------------------------------------------------------------------------
+// Copyright (c) 2026 by European Organization for Nuclear Research (CERN)
+//------------------------------------------------------------------------------
+// XRootD is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// XRootD is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with XRootD.  If not, see <http://www.gnu.org/licenses/>.
+//------------------------------------------------------------------------------
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <XrdCeph/XrdCephStripeLayout.hh>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------
+// Declaration
+//------------------------------------------------------------------------------
+class CephStripeLayoutTest: public CppUnit::TestCase
+{
+  public:
+    CPPUNIT_TEST_SUITE( CephStripeLayoutTest );
+      CPPUNIT_TEST( ObjectNameTest );
+      CPPUNIT_TEST( ValidTest );
+      CPPUNIT_TEST( SingleStripeTest );
+      CPPUNIT_TEST( MultiStripeTest );
+    CPPUNIT_TEST_SUITE_END();
+    void ObjectNameTest();
+    void ValidTest();
+    void SingleStripeTest();
+    void MultiStripeTest();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CephStripeLayoutTest );
+
+/// a piece of a mapped range : objectNo, objectOffset, fileOffset, length
+struct Piece {
+  uint64_t objectNo;
+  uint64_t objectOffset;
+  uint64_t fileOffset;
+  uint64_t len;
+  bool operator==(const Piece &o) const {
+    return objectNo == o.objectNo && objectOffset == o.objectOffset &&
+      fileOffset == o.fileOffset && len == o.len;
+  }
+};
+
+static std::vector<Piece> mapRange(const XrdCephStripeLayout &layout, uint64_t offset, uint64_t length) {
+  std::vector<Piece> pieces;
+  layout.map(offset, length, [&](uint64_t objectNo, uint64_t objectOffset, uint64_t fileOffset, uint64_t len) {
+    Piece p = { objectNo, objectOffset, fileOffset, len };
+    pieces.push_back(p);
+  });
+  return pieces;
+}
+
+//------------------------------------------------------------------------------
+// Object name test
+//------------------------------------------------------------------------------
+void CephStripeLayoutTest::ObjectNameTest() {
+  CPPUNIT_ASSERT(XrdCephStripeLayout::objectName("file", 0) == "file.0000000000000000");
+  CPPUNIT_ASSERT(XrdCephStripeLayout::objectName("dir/file", 0x1a) == "dir/file.000000000000001a");
+  CPPUNIT_ASSERT(XrdCephStripeLayout::objectName("f", 0xfedcba9876543210ull) == "f.fedcba9876543210");
+}
+
+//------------------------------------------------------------------------------
+// Valid test
+//------------------------------------------------------------------------------
+void CephStripeLayoutTest::ValidTest() {
+  CPPUNIT_ASSERT(XrdCephStripeLayout(4, 3, 8).valid());
+  CPPUNIT_ASSERT(!XrdCephStripeLayout().valid());
+  CPPUNIT_ASSERT(!XrdCephStripeLayout(4, 0, 8).valid());
+  // objects hold a whole number of stripe units
+  CPPUNIT_ASSERT(!XrdCephStripeLayout(4, 1, 6).valid());
+  CPPUNIT_ASSERT(!XrdCephStripeLayout(8, 1, 4).valid());
+}
+
+//------------------------------------------------------------------------------
+// Single stripe test : stripe unit of 4 bytes, objects of 8 bytes
+//------------------------------------------------------------------------------
+void CephStripeLayoutTest::SingleStripeTest() {
+  XrdCephStripeLayout layout(4, 1, 8);
+  // inside a stripe unit
+  std::vector<Piece> expected = { {0, 1, 1, 2} };
+  CPPUNIT_ASSERT(mapRange(layout, 1, 2) == expected);
+  // across a stripe unit boundary then an object boundary
+  expected = { {0, 2, 2, 2}, {0, 4, 4, 4}, {1, 0, 8, 4}, {1, 4, 12, 1} };
+  CPPUNIT_ASSERT(mapRange(layout, 2, 11) == expected);
+  // far in the file
+  expected = { {1000, 7, 8007, 1}, {1001, 0, 8008, 1} };
+  CPPUNIT_ASSERT(mapRange(layout, 8007, 2) == expected);
+  CPPUNIT_ASSERT(mapRange(layout, 5, 0).empty());
+}
+
+//------------------------------------------------------------------------------
+// Multi stripe test : stripe unit of 4 bytes over 3 objects of 8 bytes, an
+// object set hence covering 24 bytes of the file :
+//   file bytes  0- 3 -> object 0 [0,4[    12-15 -> object 0 [4,8[
+//   file bytes  4- 7 -> object 1 [0,4[    16-19 -> object 1 [4,8[
+//   file bytes  8-11 -> object 2 [0,4[    20-23 -> object 2 [4,8[
+//   file bytes 24-27 -> object 3 [0,4[    ...
+//------------------------------------------------------------------------------
+void CephStripeLayoutTest::MultiStripeTest() {
+  XrdCephStripeLayout layout(4, 3, 8);
+  // across stripe units, stripes, objects and the first object set
+  std::vector<Piece> expected = { {0, 2, 2, 2}, {1, 0, 4, 4}, {2, 0, 8, 4}, {0, 4, 12, 4},
+                                  {1, 4, 16, 4}, {2, 4, 20, 4}, {3, 0, 24, 3} };
+  CPPUNIT_ASSERT(mapRange(layout, 2, 25) == expected);
+  // second stripe of the second object set
+  expected = { {4, 5, 41, 3}, {5, 4, 44, 2} };
+  CPPUNIT_ASSERT(mapRange(layout, 41, 5) == expected);
+  // third object set
+  expected = { {8, 4, 68, 4} };
+  CPPUNIT_ASSERT(mapRange(layout, 68, 4) == expected);
+  // the pieces cover the range contiguously in file order
+  uint64_t next = 7;
+  uint64_t total = 0;
+  for (auto &p : mapRange(layout, 7, 1000)) {
+    CPPUNIT_ASSERT(p.fileOffset == next && p.len > 0 && p.len <= 4);
+    CPPUNIT_ASSERT(p.objectOffset + p.len <= 8);
+    next += p.len;
+    total += p.len;
+  }
+  CPPUNIT_ASSERT(total == 1000);
+}